@@ -0,0 +1,13 @@
+#version 330 core
+// Shows the hits accumulated by the chaos game. The expected hits per pixel on the triangle grow
+// with the points drawn, so they are scaled by exposure to stay about the same brightness.
+out vec4 FragColor;
+uniform sampler2D accumulation; // hits per pixel, same size as the framebuffer
+uniform float exposure; // pixels the triangle covers divided by the points drawn so far
+
+void main()
+{
+    float hits = texelFetch(accumulation, ivec2(gl_FragCoord.xy), 0).r;
+    float brightness = 1.0 - exp(-hits * exposure);
+    FragColor = vec4(0.25, brightness, 0.75, brightness);
+}
\ No newline at end of file
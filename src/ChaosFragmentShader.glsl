@@ -0,0 +1,7 @@
+#version 330 core
+// Every point adds one hit to its pixel of the float accumulation buffer, with additive blending
+out vec4 FragColor;
+void main()
+{
+    FragColor = vec4(1.0);
+}
\ No newline at end of file
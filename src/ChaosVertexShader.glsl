@@ -0,0 +1,7 @@
+#version 330 core
+layout (location = 0) in vec2 aPos; // a point of the chaos game, or a corner of the background rectangle
+
+void main()
+{
+    gl_Position = vec4(aPos, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#version 330 core
+// No vertex attributes: every vertex of the Sierpinski Triangle is decoded from gl_VertexID,
+// using the same layout as initSierpinski in sierpinski.cpp:
+//  - the levels are stored one after the other, level L holding 3^L triangles
+//  - within level L, triangle c * 3^(L-1) + i is the child at corner c of triangle i of level L-1
+// so the base 3 digits of a triangle's index within its level, least significant first,
+// are the corners picked from the outer triangle down to it.
+
+out vec3 ourColor; // specify a color output to the fragment shader
+uniform int maxDepth; // depth of the whole triangle, used to normalize the color
+uniform vec4 tile; // scale (xy) and offset (zw) taking the whole image to the part being drawn, see ImageExport
+const float levelZStep = 1.0 / 64.0; // z between depth levels, LEVEL_Z_STEP in sierpinski.h
+
+const vec2 corners[3] = vec2[3](vec2(-0.5, -0.5), vec2(0.0, 0.5), vec2(0.5, -0.5));
+
+void main()
+{
+    //find the level of this vertex's triangle, and its index within that level
+    int tri = gl_VertexID / 3;
+    int level = 0;
+    int levelSize = 1;
+    while(tri >= levelSize){
+        tri -= levelSize;
+        levelSize *= 3;
+        level++;
+    }
+
+    //walk down from the outer triangle, shrinking by half towards one corner per level
+    vec2 offset = vec2(0.0);
+    float scale = 1.0;
+    for(int i = 0; i < level; i++){
+        offset += scale * 0.5 * corners[tri % 3];
+        scale *= 0.5;
+        tri /= 3;
+    }
+
+    gl_Position = vec4((offset + scale * corners[gl_VertexID % 3]) * tile.xy + tile.zw, -float(level) * levelZStep, 1.0);
+    ourColor = vec3(0.25, maxDepth > 0 ? float(level) / float(maxDepth) : 0.0, 0.75);
+}
\ No newline at end of file
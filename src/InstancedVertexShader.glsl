@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;      // corner of the unit triangle, attribute position 0
+layout (location = 1) in vec4 aInstance; // per instance: xy offset, z scale, w depth level
+
+out vec3 ourColor; // specify a color output to the fragment shader
+uniform float maxDepth; // depth of the whole triangle, used to normalize the color
+uniform vec4 tile; // scale (xy) and offset (zw) taking the whole image to the part being drawn, see ImageExport
+const float levelZStep = 1.0 / 64.0; // z between depth levels, LEVEL_Z_STEP in sierpinski.h
+
+void main()
+{
+    gl_Position = vec4((aInstance.xy + aInstance.z * aPos) * tile.xy + tile.zw, -aInstance.w * levelZStep, 1.0);
+    ourColor = vec3(0.25, maxDepth > 0.0 ? aInstance.w / maxDepth : 0.0, 0.75);
+}
\ No newline at end of file
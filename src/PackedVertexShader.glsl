@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;   // normalized 16 bit position, attribute position 0
+layout (location = 1) in uint aDepth; // depth level of the vertex, attribute position 1
+
+out vec3 ourColor; // specify a color output to the fragment shader
+uniform int maxDepth; // depth of the whole triangle, used to normalize the depth
+uniform vec3 palette[2]; // colors of the outer triangle and of the deepest level
+uniform vec4 tile; // scale (xy) and offset (zw) taking the whole image to the part being drawn, see ImageExport
+const float levelZStep = 1.0 / 64.0; // z between depth levels, LEVEL_Z_STEP in sierpinski.h
+
+void main()
+{
+    gl_Position = vec4(aPos * tile.xy + tile.zw, -float(aDepth) * levelZStep, 1.0);
+    ourColor = mix(palette[0], palette[1], maxDepth > 0 ? float(aDepth) / float(maxDepth) : 0.0);
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#version 330 core
+// Works out per pixel which levels of the Sierpinski Triangle cover it, without any geometry.
+// In lattice coordinates (t along the base, s up towards the top corner) the outer triangle is
+// t, s >= 0 and t + s <= 1. At level L it is cut into a 2^L grid of cells (i, j), and the point
+// is in a level L triangle exactly when its cell has (i & j) == 0 (an odd entry of Pascal's
+// triangle) and it lies in the lower left half of that cell; the upper right halves are holes.
+in vec2 imagePos;
+out vec4 FragColor;
+uniform int maxDepth; // depth of the whole triangle, used to normalize the color
+uniform int drawDepth; // deepest level tested, levels smaller than a pixel are left out
+
+void main()
+{
+    float s = imagePos.y + 0.5;
+    float t = imagePos.x + 0.5 - 0.5 * s;
+    if(s < 0.0 || t < 0.0 || s + t > 1.0){
+        discard;
+    }
+
+    //find the deepest level whose triangles still cover this pixel
+    int level = 0;
+    float cells = 2.0;
+    for(int l = 1; l <= drawDepth; l++){
+        vec2 cell = vec2(t, s) * cells;
+        ivec2 index = ivec2(cell);
+        vec2 inside = fract(cell);
+        if((index.x & index.y) != 0 || inside.x + inside.y >= 1.0){
+            break;
+        }
+        level = l;
+        cells *= 2.0;
+    }
+    FragColor = vec4(0.25, maxDepth > 0 ? float(level) / float(maxDepth) : 0.0, 0.75, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec3 aPos; // corner of the background rectangle, attribute position 0
+
+out vec2 imagePos; // position in the whole image, before the tile is picked out of it
+uniform vec4 tile; // scale (xy) and offset (zw) taking the whole image to the part being drawn, see ImageExport
+
+void main()
+{
+    imagePos = aPos.xy;
+    gl_Position = vec4(aPos.xy * tile.xy + tile.zw, 0.0, 1.0);
+}
\ No newline at end of file
@@ -4,9 +4,10 @@ layout (location = 1) in vec3 aColor; //color variable has attribute position 1
 
 out vec3 ourColor; // specify a color output to the fragment shader
 uniform float horizOffset;
+uniform vec4 tile; // scale (xy) and offset (zw) taking the whole image to the part being drawn, see ImageExport
 
 void main()
 {
-    gl_Position = vec4(aPos, 1.0); // see how we directly give a vec3 to vec4's constructor
+    gl_Position = vec4(aPos.xy * tile.xy + tile.zw, aPos.z, 1.0);
     ourColor = aColor;
 }
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 aPos; // position relative to the view the geometry was built for (z from the level), attribute position 0
+layout (location = 1) in vec3 aColor; //color variable has attribute position 1
+
+out vec3 ourColor; // specify a color output to the fragment shader
+uniform vec2 viewOffset; // offset from the view the geometry was built for to the current one
+uniform float viewScale; // zoom of the current view relative to the one the geometry was built for
+
+void main()
+{
+    gl_Position = vec4((aPos.xy + viewOffset) * viewScale, aPos.z, 1.0);
+    ourColor = aColor;
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+/**
+ * Class used to hand out scratch memory that is thrown away all at once
+ *
+*/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include<stddef.h>
+#include<stdint.h>
+#include<memory>
+#include<vector>
+#include<algorithm>
+
+#define ARENA_ALIGNMENT 64      //default alignment of allocations, a cache line and enough for any SIMD load
+
+/**
+ * A bump-pointer allocator: every allocation just moves a pointer forward in one block of memory,
+ * and reset gives all of it back at once without freeing anything.
+ * When an allocation doesn't fit in the block it gets a block of its own, and the next reset
+ * replaces everything with one block as large as the most that was ever in use, so an arena that
+ * is reset between builds of the same size stops allocating after the first one.
+ * Nothing handed out is ever constructed or destructed, so it is only meant for plain data.
+*/
+class Arena{
+    public:
+        Arena() = default;
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        /**
+         * Hands out uninitialized memory
+         * @param size the number of bytes needed
+         * @param alignment what the address has to be a multiple of, a power of two up to ARENA_ALIGNMENT
+         * @return a pointer to 'size' bytes, valid until the next reset
+        */
+        void *allocate(size_t size, size_t alignment = ARENA_ALIGNMENT){
+            size_t offset = (used + alignment - 1) & ~(alignment - 1);
+            if(offset + size <= capacity){
+                used = offset + size;
+                highWater = std::max(highWater, used + overflowBytes);
+                return base + offset;
+            }
+            //too big for what is left, so it gets its own block until the next reset
+            overflow.emplace_back(new unsigned char[size + ARENA_ALIGNMENT]);
+            overflowBytes += size + ARENA_ALIGNMENT;   //counted with its padding, so one block fits it after reset
+            highWater = std::max(highWater, used + overflowBytes);
+            return align(overflow.back().get());
+        }
+
+        /**
+         * Hands out uninitialized room for an array
+         * @param count the number of elements needed
+         * @return a pointer to 'count' elements, aligned to ARENA_ALIGNMENT
+        */
+        template<typename T>
+        T *allocate(size_t count){
+            return (T *)allocate(count * sizeof(T), std::max(alignof(T), (size_t)ARENA_ALIGNMENT));
+        }
+
+        /**
+         * Gives back everything handed out since the last reset
+         * post: - every pointer handed out is invalid
+         *       - the block holds at least the high-water mark, so allocating as much again needs no new memory
+        */
+        void reset(){
+            if(!overflow.empty()){
+                overflow.clear();
+                capacity = highWater;
+                block.reset(new unsigned char[capacity + ARENA_ALIGNMENT]);
+                base = align(block.get());
+                growCountValue++;
+            }
+            used = 0;
+            overflowBytes = 0;
+        }
+
+        /**
+         * @return the most bytes that were ever in use at once, padding for alignment included
+        */
+        size_t highWaterMark() const{
+            return highWater;
+        }
+
+        /**
+         * Starts the high-water mark over from what is in use right now, without giving back any memory
+        */
+        void resetHighWaterMark(){
+            highWater = used + overflowBytes;
+        }
+
+        /**
+         * @return the number of bytes the arena holds on to between resets
+        */
+        size_t reserved() const{
+            return capacity + overflowBytes;
+        }
+
+        /**
+         * @return how many times the block had to be replaced by a larger one
+        */
+        size_t growCount() const{
+            return growCountValue;
+        }
+
+    private:
+        std::unique_ptr<unsigned char[]> block;                 //memory handed out by the bump pointer
+        unsigned char *base = NULL;                             //first ARENA_ALIGNMENT aligned byte of 'block'
+        size_t capacity = 0;                                    //bytes of 'block' from 'base' on
+        size_t used = 0;                                        //bytes of those handed out since the last reset
+        std::vector<std::unique_ptr<unsigned char[]>> overflow; //blocks of the allocations that didn't fit
+        size_t overflowBytes = 0;                               //bytes handed out from those blocks, with padding
+        size_t highWater = 0;                                   //most bytes ever in use at once
+        size_t growCountValue = 0;                              //times 'block' was replaced by a larger one
+
+        /**
+         * private helper function that rounds an address up to ARENA_ALIGNMENT
+        */
+        static unsigned char *align(unsigned char *p){
+            return (unsigned char *)(((uintptr_t)p + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1));
+        }
+};
+
+#endif
@@ -0,0 +1,446 @@
+/**
+ * Microbenchmark of the CPU geometry generators in sierpinski.cpp and the kernels in subdivide.cpp.
+ * Builds without OpenGL or GLFW: every generator is run a few times at every depth of a sweep, and
+ * the fastest run is reported as one CSV row on stdout, together with what it allocated.
+ * Allocations are counted by replacing the global operator new and delete, so they only cover
+ * the C++ allocations of the generator itself; the output buffer stands in for a mapped stream
+ * buffer slot and is allocated with malloc, outside of the count.
+ * The generators keep their scratch memory in arenas between runs, so only the first run of a
+ * depth allocates it, and the arenas' high-water mark is reported next to the allocations.
+ *
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <new>
+#include <algorithm>
+#include <memory>
+#include "sierpinski.h"
+#include "subdivide.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define DEFAULT_BENCH_RUNS 5    //runs per generator and depth when none is given with --runs
+
+//----COUNTING ALLOCATOR----
+
+static std::atomic<size_t> allocationCount{0};     //allocations since the counters were reset
+static std::atomic<size_t> allocatedBytes{0};      //bytes allocated since the counters were reset
+static std::atomic<size_t> liveBytes{0};           //bytes allocated and not freed yet
+static std::atomic<size_t> peakBytes{0};           //most bytes live at once since the counters were reset
+
+//every block starts with its size, padded so the memory handed out keeps malloc's alignment
+static const size_t ALLOC_HEADER = alignof(max_align_t);
+
+void *operator new(size_t size){
+    char *block = (char *)malloc(size + ALLOC_HEADER);
+    if(block == NULL){
+        throw std::bad_alloc();
+    }
+    *(size_t *)block = size;
+    allocationCount++;
+    allocatedBytes += size;
+    size_t live = liveBytes += size;
+    size_t peak = peakBytes;
+    while(live > peak && !peakBytes.compare_exchange_weak(peak, live)){
+    }
+    return block + ALLOC_HEADER;
+}
+
+void operator delete(void *p) noexcept{
+    if(p == NULL){
+        return;
+    }
+    char *block = (char *)p - ALLOC_HEADER;
+    liveBytes -= *(size_t *)block;
+    free(block);
+}
+
+void *operator new[](size_t size){
+    return operator new(size);
+}
+
+void operator delete[](void *p) noexcept{
+    operator delete(p);
+}
+
+void operator delete(void *p, size_t) noexcept{
+    operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept{
+    operator delete(p);
+}
+
+/**
+ * Starts counting allocations from zero, with the peak starting at what is live right now
+*/
+static void resetAllocationCounters(){
+    allocationCount = 0;
+    allocatedBytes = 0;
+    peakBytes = liveBytes.load();
+}
+
+/**
+ * @return the peak resident set size of the process in kilobytes, 0 if it is not known
+*/
+static size_t peakResidentKB(){
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))){
+        return counters.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0){
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;      //bytes on macOS, kilobytes everywhere else
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+//----GENERATORS----
+
+int benchThreads = 0;       //threads used by the parallel generators, --threads, 0 = one per core
+
+/**
+ * A generator being benchmarked
+ * name: the name it is reported under
+ * vertices: the number of vertices it builds for a depth, 0 if the depth is too deep for it
+ * outputSize: the size in bytes of the buffer it writes a triangle of a depth to
+ * run: generates a triangle of a depth into a buffer of outputSize(depth) bytes
+ * supported: false if it can't run on this CPU
+*/
+struct Generator{
+    const char *name;
+    size_t (*vertices)(int depth);
+    size_t (*outputSize)(int depth);
+    void (*run)(void *out, int depth);
+    bool (*supported)();
+};
+
+static size_t sierpinskiVertices(int depth){
+    return sierpinskiVertexCount(depth);
+}
+
+/**
+ * @param name the name of a fractal
+ * @param depth the depth to build it at
+ * @return the number of vertices of the fractal at 'depth', 0 if that is deeper than the
+ *         Sierpinski Triangle of depth MAX_SIERPINSKI_DEPTH in vertices
+*/
+static size_t fractalVertices(const char *name, int depth){
+    const fractal_t &fractal = *findFractal(name);
+    if(depth > fractalMaxDepth(fractal, sierpinskiVertexCount(MAX_SIERPINSKI_DEPTH))){
+        return 0;
+    }
+    return fractalVertexCount(fractal, depth);
+}
+
+static size_t ifsSierpinskiVertices(int depth){
+    return fractalVertices("sierpinski-ifs", depth);
+}
+
+static size_t carpetVertices(int depth){
+    return fractalVertices("carpet", depth);
+}
+
+static size_t vicsekVertices(int depth){
+    return fractalVertices("vicsek", depth);
+}
+
+static size_t kochVertices(int depth){
+    return fractalVertices("koch", depth);
+}
+
+static size_t ifsSierpinskiSize(int depth){
+    return ifsSierpinskiVertices(depth) * sizeof(vertex_t);
+}
+
+static size_t carpetSize(int depth){
+    return carpetVertices(depth) * sizeof(vertex_t);
+}
+
+static size_t vicsekSize(int depth){
+    return vicsekVertices(depth) * sizeof(vertex_t);
+}
+
+static size_t kochSize(int depth){
+    return kochVertices(depth) * sizeof(vertex_t);
+}
+
+static size_t vertexSize(int depth){
+    return sierpinskiVertexCount(depth) * sizeof(vertex_t);
+}
+
+static size_t packedSize(int depth){
+    return sierpinskiVertexCount(depth) * sizeof(packed_vertex_t);
+}
+
+static size_t instanceSize(int depth){
+    return sierpinskiVertexCount(depth) / 3 * sizeof(instance_t);
+}
+
+static size_t chaosSize(int depth){
+    return sierpinskiVertexCount(depth) * 2 * sizeof(float);
+}
+
+static size_t noOutput(int depth){
+    return 0;
+}
+
+static bool always(){
+    return true;
+}
+
+static void runVertices(void *out, int depth){
+    initSierpinski((vertex_t *)out, depth);
+}
+
+static void runPacked(void *out, int depth){
+    initSierpinski((packed_vertex_t *)out, depth);
+}
+
+static void runVerticesParallel(void *out, int depth){
+    initSierpinskiParallel((vertex_t *)out, depth, benchThreads);
+}
+
+static void runPackedParallel(void *out, int depth){
+    initSierpinskiParallel((packed_vertex_t *)out, depth, benchThreads);
+}
+
+static void runIFSSierpinski(void *out, int depth){
+    initFractalParallel((vertex_t *)out, *findFractal("sierpinski-ifs"), depth, benchThreads);
+}
+
+static void runCarpet(void *out, int depth){
+    initFractalParallel((vertex_t *)out, *findFractal("carpet"), depth, benchThreads);
+}
+
+static void runVicsek(void *out, int depth){
+    initFractalParallel((vertex_t *)out, *findFractal("vicsek"), depth, benchThreads);
+}
+
+static void runKoch(void *out, int depth){
+    initFractalParallel((vertex_t *)out, *findFractal("koch"), depth, benchThreads);
+}
+
+static void runInstances(void *out, int depth){
+    initSierpinskiInstances((instance_t *)out, depth);
+}
+
+static void runIndexed(void *out, int depth){
+    std::vector<vertex_t> vertices;
+    std::vector<unsigned int> indices;
+    initSierpinskiIndexed(vertices, indices, depth);
+}
+
+/**
+ * Plays the chaos game for as many points as a mesh of a depth has vertices, on one walker
+ * per thread like RENDER_CHAOS does
+*/
+static void runChaos(void *out, int depth){
+    static std::vector<chaos_walker_t> walkers;
+    static std::unique_ptr<WorkerPool> pool;
+    if(walkers.empty()){
+        walkers.resize(benchThreads > 0 ? benchThreads : std::max(1u, std::thread::hardware_concurrency()));
+        pool.reset(new WorkerPool(walkers.size()));
+        for(size_t i = 0; i < walkers.size(); i++){
+            seedChaosWalker(walkers[i], i);
+        }
+    }
+    chaosGameParallel(*pool, walkers, (float *)out, sierpinskiVertexCount(depth));
+}
+
+/**
+ * Subdivides the outer triangle down to a depth with one kernel, without writing any vertices,
+ * so the kernels can be compared with each other
+ * @param kernel the kernel to subdivide with
+ * @param depth the deepest level to build
+*/
+static void subdivideLevels(subdivide_kernel_t kernel, int depth){
+    float outer[6] = {-0.5f, -0.5f,  0.0f,  0.5f,  0.5f, -0.5f};
+    triangles_t root = {&outer[0], &outer[1], &outer[2], &outer[3], &outer[4], &outer[5], 1};
+    std::vector<float> scratch[2];
+    triangles_t levels[2];
+    const triangles_t *current = &root;
+    for(int level = 1; level <= depth; level++){
+        triangles_t &next = levels[level % 2];
+        allocTriangles(next, scratch[level % 2], 3 * current->count);
+        kernel(*current, next);
+        current = &next;
+    }
+}
+
+static void runSubdivideScalar(void *out, int depth){
+    subdivideLevels(subdivideScalar, depth);
+}
+
+#ifdef SUBDIVIDE_X86
+static void runSubdivideSSE(void *out, int depth){
+    subdivideLevels(subdivideSSE, depth);
+}
+
+static void runSubdivideAVX2(void *out, int depth){
+    subdivideLevels(subdivideAVX2, depth);
+}
+
+static bool hasSSE(){
+    return __builtin_cpu_supports("sse");
+}
+
+static bool hasAVX2(){
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#ifdef SUBDIVIDE_NEON
+static void runSubdivideNEON(void *out, int depth){
+    subdivideLevels(subdivideNEON, depth);
+}
+#endif
+
+static const Generator generators[] = {
+    {"vertices",            sierpinskiVertices,     vertexSize,     runVertices,            always},
+    {"vertices-parallel",   sierpinskiVertices,     vertexSize,     runVerticesParallel,    always},
+    {"packed",              sierpinskiVertices,     packedSize,     runPacked,              always},
+    {"packed-parallel",     sierpinskiVertices,     packedSize,     runPackedParallel,      always},
+    {"instances",           sierpinskiVertices,     instanceSize,   runInstances,           always},
+    {"indexed",             sierpinskiVertices,     noOutput,       runIndexed,             always},
+    {"chaos",               sierpinskiVertices,     chaosSize,      runChaos,               always},
+    {"ifs-sierpinski",      ifsSierpinskiVertices,  ifsSierpinskiSize, runIFSSierpinski,   always},
+    {"carpet",              carpetVertices,         carpetSize,     runCarpet,              always},
+    {"vicsek",              vicsekVertices,         vicsekSize,     runVicsek,              always},
+    {"koch",                kochVertices,           kochSize,       runKoch,                always},
+    {"subdivide-scalar",    sierpinskiVertices,     noOutput,       runSubdivideScalar,     always},
+#ifdef SUBDIVIDE_X86
+    {"subdivide-sse",       sierpinskiVertices,     noOutput,       runSubdivideSSE,        hasSSE},
+    {"subdivide-avx2",      sierpinskiVertices,     noOutput,       runSubdivideAVX2,       hasAVX2},
+#endif
+#ifdef SUBDIVIDE_NEON
+    {"subdivide-neon",      sierpinskiVertices,     noOutput,       runSubdivideNEON,       always},
+#endif
+};
+static const int GENERATOR_COUNT = sizeof(generators) / sizeof(generators[0]);
+
+//----BENCHMARK----
+
+int benchRuns = DEFAULT_BENCH_RUNS;     //runs per generator and depth, --runs
+int benchMinDepth = 4;                  //depths swept, --depths
+int benchMaxDepth = MAX_SIERPINSKI_DEPTH;
+const char *benchOnly = NULL;           //only run the generator with this name, --generator
+
+/**
+ * Parses the command line arguments of the benchmark
+ * Supported arguments:
+ *      --depths A-B        depths swept (4-MAX_SIERPINSKI_DEPTH), or a single depth
+ *      --runs N            runs per generator and depth, the fastest one is reported
+ *      --threads N         threads used by the parallel generators, 0 = one per core
+ *      --generator NAME    only run one generator
+ * @param argc the number of arguments
+ * @param argv the arguments
+ * @return 0 on success, -1 if an argument was not recognized or invalid
+*/
+int parseArgs(int argc, char **argv){
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--depths") == 0 && i + 1 < argc){
+            int read = sscanf(argv[++i], "%d-%d", &benchMinDepth, &benchMaxDepth);
+            if(read == 1){
+                benchMaxDepth = benchMinDepth;
+            }
+            if(read < 1 || benchMinDepth < 0 || benchMinDepth > benchMaxDepth || benchMaxDepth > MAX_SIERPINSKI_DEPTH){
+                printf("Depths must be a range within 0-%d\n", MAX_SIERPINSKI_DEPTH);
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--runs") == 0 && i + 1 < argc){
+            benchRuns = atoi(argv[++i]);
+            if(benchRuns <= 0){
+                printf("Runs must be at least 1\n");
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            benchThreads = atoi(argv[++i]);
+            if(benchThreads < 0){
+                printf("Threads must be 0 (one per core) or more\n");
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--generator") == 0 && i + 1 < argc){
+            benchOnly = argv[++i];
+        } else{
+            printf("Usage: %s [--depths MIN-MAX] [--runs N] [--threads N] [--generator NAME]\n", argv[0]);
+            printf("Generators:");
+            for(int g = 0; g < GENERATOR_COUNT; g++){
+                printf(" %s", generators[g].name);
+            }
+            printf("\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv){
+    if(parseArgs(argc, argv) != 0){
+        return -1;
+    }
+    fprintf(stderr, "subdivide kernel: %s\n", subdivideKernelName());
+    printf("generator,depth,vertices,best_ms,ns_per_vertex,bytes_allocated,allocations,peak_heap_bytes,scratch_high_water_bytes,peak_rss_kb\n");
+    for(int depth = benchMinDepth; depth <= benchMaxDepth; depth++){
+        //one output buffer per depth, touched up front so page faults aren't timed
+        size_t outSize = 0;
+        for(int g = 0; g < GENERATOR_COUNT; g++){
+            outSize = std::max(outSize, generators[g].outputSize(depth));
+        }
+        void *out = malloc(std::max(outSize, (size_t)1));
+        if(out == NULL){
+            printf("Failed to allocate %zu bytes for depth %d\n", outSize, depth);
+            return -1;
+        }
+        memset(out, 0, outSize);
+
+        for(int g = 0; g < GENERATOR_COUNT; g++){
+            const Generator &gen = generators[g];
+            size_t vertices = gen.vertices(depth);
+            if(!gen.supported() || vertices == 0 || (benchOnly != NULL && strcmp(benchOnly, gen.name) != 0)){
+                continue;
+            }
+            double best = 0.0;
+            size_t allocations = 0, bytes = 0, peak = 0;
+            resetGeneratorScratchStats();
+            for(int run = 0; run < benchRuns; run++){
+                size_t liveBefore = liveBytes;
+                resetAllocationCounters();
+                auto start = std::chrono::steady_clock::now();
+                gen.run(out, depth);
+                auto end = std::chrono::steady_clock::now();
+                double ms = std::chrono::duration<double, std::milli>(end - start).count();
+                if(run == 0 || ms < best){
+                    best = ms;
+                }
+                //every run allocates the same, so keep the counters of the last one
+                allocations = allocationCount;
+                bytes = allocatedBytes;
+                peak = peakBytes - liveBefore;
+            }
+            printf("%s,%d,%zu,%.3f,%.3f,%zu,%zu,%zu,%zu,%zu\n", gen.name, depth, vertices, best,
+                   best * 1e6 / vertices, bytes, allocations, peak, generatorScratchStats().highWater,
+                   peakResidentKB());
+            fflush(stdout);
+        }
+        free(out);
+    }
+    return 0;
+}
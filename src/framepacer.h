@@ -0,0 +1,63 @@
+/**
+ * Class used to hold the render loop to a frame rate
+ *
+*/
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include<chrono>
+#include<thread>
+
+#define FRAME_PACER_SPIN_MS 2.0     //last part of every wait spent spinning, longer than the OS oversleeps by
+
+/**
+ * A frame limiter: wait() returns at evenly spaced deadlines, one frame period apart.
+ * Sleeping alone wakes up too late by up to a scheduler tick, and spinning alone keeps a core
+ * busy, so it sleeps until FRAME_PACER_SPIN_MS before the deadline and spins the rest of the way.
+ * Deadlines follow on from each other rather than from when wait() was called, so the frame rate
+ * doesn't drift, but a frame that runs more than a period late starts the schedule over instead
+ * of being followed by a burst of frames catching up.
+*/
+class FramePacer{
+    typedef std::chrono::steady_clock clock;
+
+    public:
+        /**
+         * Constructor for a FramePacer
+         * @param fps the frame rate to hold to, 0 or less to not hold back at all
+        */
+        FramePacer(double fps){
+            if(fps > 0.0){
+                period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / fps));
+            }
+            next = clock::now();
+        }
+
+        /**
+         * Waits for the deadline of the next frame
+         * post: the deadline after that one is a period later
+        */
+        void wait(){
+            if(period == clock::duration::zero()){
+                return;
+            }
+            clock::time_point now = clock::now();
+            if(now - next > period){
+                next = now;
+            }
+            next += period;
+            clock::time_point wake = next - std::chrono::duration_cast<clock::duration>(
+                                                std::chrono::duration<double, std::milli>(FRAME_PACER_SPIN_MS));
+            if(now < wake){
+                std::this_thread::sleep_until(wake);
+            }
+            while(clock::now() < next){
+            }
+        }
+
+    private:
+        clock::duration period = clock::duration::zero();   //time between deadlines, 0 when not limiting
+        clock::time_point next;                              //deadline of the last frame waited for
+};
+
+#endif
@@ -0,0 +1,326 @@
+/**
+ * Class used to keep generated geometry in files, so deep triangles don't need to be rebuilt every start
+ *
+*/
+#ifndef GEOMETRYCACHE_H
+#define GEOMETRYCACHE_H
+
+#include<stdio.h>
+#include<string.h>
+#include<stddef.h>
+#include<stdint.h>
+#include<string>
+#include "sierpinski.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX            //keep windows.h from defining min and max over std::min and std::max
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include<windows.h>
+#else
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#endif
+
+#define GEOMETRY_CACHE_VERSION 2        //bump whenever the generators or the vertex formats change
+#define GEOMETRY_CACHE_MAX_LEVELS 32    //most levels a file describes
+#define GEOMETRY_CACHE_ALIGNMENT 4096   //the vertices start at a multiple of this, so they are page aligned
+
+//vertex formats a cache file can hold
+enum GeometryFormat{
+    GEOMETRY_VERTICES = 1,      //vertex_t (RENDER_VERTICES)
+    GEOMETRY_PACKED = 2         //packed_vertex_t (RENDER_PACKED)
+};
+
+/**
+ * Header at the start of every cache file, followed by the vertices at payloadOffset
+ * magic: "SIERPGEO"
+ * version: GEOMETRY_CACHE_VERSION of the program that wrote it
+ * byteOrder: 0x01020304 as written by that program, so files from machines of another byte order are rejected
+ * format: the GeometryFormat of the vertices
+ * vertexSize: sizeof of that format when it was written
+ * depth: the deepest level held
+ * fractal: name of the fractal, see fractal_t
+ * vertexCount: the number of vertices held
+ * payloadOffset: where in the file the vertices start
+ * levelOffsets: the first vertex of every level 0 to depth, then vertexCount
+*/
+typedef struct{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t format;
+    uint32_t vertexSize;
+    int32_t depth;
+    char fractal[36];
+    uint64_t vertexCount;
+    uint64_t payloadOffset;
+    uint64_t levelOffsets[GEOMETRY_CACHE_MAX_LEVELS + 1];
+} geometry_cache_header_t;
+
+/**
+ * A cache file of the vertices of a fractal at one depth, mapped into memory. An existing file is
+ * opened read-only with openRead and its vertices used in place, straight out of the page cache.
+ * A new one is made with create, which maps the file writable so the generators can write into it
+ * directly, and only appears under its real name once commit is called, so a run that is stopped
+ * halfway never leaves a broken file behind.
+*/
+class GeometryFile{
+    public:
+        GeometryFile() = default;
+
+        /**
+         * Deconstructor for the GeometryFile.
+         * Unmaps the file, removing it if it was created and never committed
+        */
+        ~GeometryFile(){
+            close();
+        }
+
+        GeometryFile(const GeometryFile &) = delete;
+        GeometryFile &operator=(const GeometryFile &) = delete;
+
+        /**
+         * Maps an existing cache file, if it holds exactly the geometry asked for
+         * @param path the path of the file
+         * @param fractal the fractal the geometry should be of
+         * @param format the GeometryFormat the vertices should be in
+         * @param vertexSize the size of one vertex in that format
+         * @param depth the depth the geometry should have
+         * @return false if the file does not exist or holds other (or broken) geometry
+         * post: if true was returned, vertices() points at the fractalVertexCount(fractal, depth) vertices
+        */
+        bool openRead(const char *path, const fractal_t &fractal, uint32_t format, uint32_t vertexSize, int depth){
+            close();
+            geometry_cache_header_t expected;
+            if(!makeHeader(expected, fractal, format, vertexSize, depth) || !map(path, 0)){
+                close();
+                return false;
+            }
+            const geometry_cache_header_t *found = (const geometry_cache_header_t *)data;
+            //everything up to the payload offset has to match, and the file has to hold every vertex
+            bool valid = size >= sizeof(geometry_cache_header_t)
+                         && memcmp(found, &expected, offsetof(geometry_cache_header_t, payloadOffset)) == 0
+                         && found->payloadOffset == expected.payloadOffset
+                         && memcmp(found->levelOffsets, expected.levelOffsets, sizeof(expected.levelOffsets)) == 0
+                         && size >= expected.payloadOffset + expected.vertexCount * vertexSize;
+            if(!valid){
+                close();
+                return false;
+            }
+            vertexBytes = expected.vertexCount * vertexSize;
+#ifndef _WIN32
+            //the vertices are read once front to back, so have the kernel read ahead of us
+            madvise(data, size, MADV_SEQUENTIAL);
+            madvise(data, size, MADV_WILLNEED);
+#endif
+            return true;
+        }
+
+        /**
+         * Makes a new cache file next to 'path' and maps it so the vertices can be written into it
+         * @param path the path the file will have once committed
+         * @param fractal the fractal the geometry is of
+         * @param format the GeometryFormat the vertices will be written in
+         * @param vertexSize the size of one vertex in that format
+         * @param depth the depth of the geometry
+         * @return a pointer to room for fractalVertexCount(fractal, depth) vertices, page aligned,
+         *         or NULL if the file could not be made
+         * post: the file is only kept if commit is called once the vertices are written
+        */
+        void *create(const char *path, const fractal_t &fractal, uint32_t format, uint32_t vertexSize, int depth){
+            close();
+            geometry_cache_header_t header;
+            if(!makeHeader(header, fractal, format, vertexSize, depth)){
+                return NULL;
+            }
+            finalPath = path;
+            tempPath = finalPath + ".tmp";
+            if(!map(tempPath.c_str(), header.payloadOffset + header.vertexCount * vertexSize)){
+                printf("Failed to create geometry cache file %s\n", tempPath.c_str());
+                close();
+                return NULL;
+            }
+            memcpy(data, &header, sizeof(header));
+            vertexBytes = header.vertexCount * vertexSize;
+            return (char *)data + header.payloadOffset;
+        }
+
+        /**
+         * Finishes a file made by create, replacing any older file at its path
+         * @return false if the file could not be moved to its path, in which case it is removed
+         * pre: create succeeded, and every vertex was written
+         * post: the file is no longer mapped
+        */
+        bool commit(){
+            std::string temp = tempPath;
+            tempPath.clear();       //so close doesn't remove it
+            close();
+#ifdef _WIN32
+            bool moved = MoveFileExA(temp.c_str(), finalPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+            bool moved = rename(temp.c_str(), finalPath.c_str()) == 0;
+#endif
+            if(!moved){
+                printf("Failed to write geometry cache file %s\n", finalPath.c_str());
+                remove(temp.c_str());
+            }
+            return moved;
+        }
+
+        /**
+         * @return the vertices of the file, NULL if nothing is mapped
+        */
+        const void *vertices() const{
+            if(data == NULL){
+                return NULL;
+            }
+            return (const char *)data + ((const geometry_cache_header_t *)data)->payloadOffset;
+        }
+
+        /**
+         * @return the size of the vertices in bytes
+        */
+        size_t verticesSize() const{
+            return vertexBytes;
+        }
+
+        /**
+         * Unmaps the file, removing it if it was made by create and not committed
+         * post: nothing is mapped
+        */
+        void close(){
+#ifdef _WIN32
+            if(data != NULL){
+                UnmapViewOfFile(data);
+            }
+            if(mapping != NULL){
+                CloseHandle(mapping);
+            }
+            if(file != INVALID_HANDLE_VALUE){
+                CloseHandle(file);
+            }
+            mapping = NULL;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if(data != NULL){
+                munmap(data, size);
+            }
+            if(file >= 0){
+                ::close(file);
+            }
+            file = -1;
+#endif
+            data = NULL;
+            size = 0;
+            vertexBytes = 0;
+            if(!tempPath.empty()){
+                remove(tempPath.c_str());
+                tempPath.clear();
+            }
+        }
+
+    private:
+        void *data = NULL;          //the mapped file, header first
+        size_t size = 0;            //size of the mapping in bytes
+        size_t vertexBytes = 0;     //size of the vertices in bytes
+        std::string finalPath;      //path a created file is moved to by commit
+        std::string tempPath;       //path of a created file until it is committed, empty otherwise
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+#else
+        int file = -1;
+#endif
+
+        /**
+         * private helper function that fills in the header a file of some geometry has
+         * @return false if the geometry has more levels than a header can describe
+        */
+        static bool makeHeader(geometry_cache_header_t &header, const fractal_t &fractal, uint32_t format,
+                               uint32_t vertexSize, int depth){
+            if(depth < 0 || depth >= GEOMETRY_CACHE_MAX_LEVELS){
+                return false;
+            }
+            memset(&header, 0, sizeof(header));     //also clears padding, which is compared by openRead
+            memcpy(header.magic, "SIERPGEO", 8);
+            header.version = GEOMETRY_CACHE_VERSION;
+            header.byteOrder = 0x01020304;
+            header.format = format;
+            header.vertexSize = vertexSize;
+            header.depth = depth;
+            strncpy(header.fractal, fractal.name, sizeof(header.fractal) - 1);
+            header.vertexCount = fractalVertexCount(fractal, depth);
+            header.payloadOffset = (sizeof(header) + GEOMETRY_CACHE_ALIGNMENT - 1)
+                                   / GEOMETRY_CACHE_ALIGNMENT * GEOMETRY_CACHE_ALIGNMENT;
+            for(int level = 0; level <= depth; level++){
+                header.levelOffsets[level] = fractalLevelOffset(fractal, level);
+            }
+            header.levelOffsets[depth + 1] = header.vertexCount;
+            return true;
+        }
+
+        /**
+         * private helper function that maps a file
+         * @param path the path of the file
+         * @param createSize 0 to map an existing file read-only, otherwise the size of a
+         *                   new file to make and map writable
+         * @return false if the file could not be opened or mapped
+        */
+        bool map(const char *path, size_t createSize){
+            bool writable = createSize != 0;
+#ifdef _WIN32
+            file = CreateFileA(path, writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                               writable ? 0 : FILE_SHARE_READ, NULL, writable ? CREATE_ALWAYS : OPEN_EXISTING,
+                               FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if(file == INVALID_HANDLE_VALUE){
+                return false;
+            }
+            if(writable){
+                size = createSize;
+            } else{
+                LARGE_INTEGER fileSize;
+                if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0){
+                    return false;
+                }
+                size = (size_t)fileSize.QuadPart;
+            }
+            //a writable mapping larger than the file grows the file to its size
+            mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                         (DWORD)((uint64_t)createSize >> 32), (DWORD)createSize, NULL);
+            if(mapping == NULL){
+                return false;
+            }
+            data = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+#else
+            file = open(path, writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+            if(file < 0){
+                return false;
+            }
+            if(writable){
+                if(ftruncate(file, createSize) != 0){
+                    return false;
+                }
+                size = createSize;
+            } else{
+                struct stat info;
+                if(fstat(file, &info) != 0 || info.st_size == 0){
+                    return false;
+                }
+                size = (size_t)info.st_size;
+            }
+            data = mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+            if(data == MAP_FAILED){
+                data = NULL;
+            }
+#endif
+            return data != NULL;
+        }
+};
+
+#endif
@@ -0,0 +1,250 @@
+/**
+ * Subdivision kernels for fractals made by an iterated function system (IFS): a set of affine
+ * maps that each shrink the whole fractal onto one of its parts.
+ * Everything is worked out at compile time from a constexpr table of maps, so each fractal gets
+ * its own kernel with the coefficients folded in, and weights of 0 or 1 cost nothing.
+ * Like subdivide, a level is kept as triangles_t and subdivided as a whole, with child m of parent
+ * i at m * parents.count + i. The children of a triangle are always inside it: they are the maps
+ * applied in the triangle's own frame, so the kernels don't care where in the level it is.
+*/
+#ifndef IFS_H
+#define IFS_H
+
+#include <string.h>
+#include <utility>
+#include "mytypes.h"
+#include "subdivide.h"
+
+typedef struct{
+    float a, b, c, d;   //linear part: x' = a x + b y, y' = c x + d y
+    float e, f;         //offset added to x' and y'
+} affine_t;
+
+/**
+ * An iterated function system on triangles
+ * MapCount: the number of maps, so the number of children every triangle has
+ * maps: the maps, child m of a triangle is maps[m] applied to it in its own frame
+ * base: the corners (x, y) of the triangle the maps are given relative to, which must not be flat
+*/
+template<int MapCount>
+struct IFS{
+    affine_t maps[MapCount];
+    float base[6];
+};
+
+/**
+ * A map that shrinks everything towards a point
+ * @param ratio how much the map shrinks by
+ * @param x the x of the point left where it is
+ * @param y the y of the point left where it is
+*/
+constexpr affine_t shrinkTowards(float ratio, float x, float y){
+    return {ratio, 0.0f, 0.0f, ratio, x * (1.0f - ratio), y * (1.0f - ratio)};
+}
+
+/**
+ * The same IFS as a table of barycentric weights: corner v of child m is
+ * w[m][v][0] * a + w[m][v][1] * b + w[m][v][2] * c, for a parent with corners a, b and c
+*/
+template<int MapCount>
+struct SubdivisionRule{
+    float w[MapCount][3][3];
+};
+
+/**
+ * Works out the subdivision rule of an IFS, at compile time when 'ifs' is constexpr
+ * @param ifs the iterated function system
+ * @return the weights of the parent's corners making up every corner of every child
+*/
+template<int MapCount>
+constexpr SubdivisionRule<MapCount> subdivisionRule(const IFS<MapCount> &ifs){
+    SubdivisionRule<MapCount> rule = {};
+    const float *p = ifs.base;
+    float det = (p[2] - p[0]) * (p[5] - p[1]) - (p[4] - p[0]) * (p[3] - p[1]);
+    for(int m = 0; m < MapCount; m++){
+        const affine_t &f = ifs.maps[m];
+        for(int v = 0; v < 3; v++){
+            //the corner the map takes base corner v to, written in barycentric coordinates of the base
+            float x = f.a * p[2 * v] + f.b * p[2 * v + 1] + f.e;
+            float y = f.c * p[2 * v] + f.d * p[2 * v + 1] + f.f;
+            float wb = ((x - p[0]) * (p[5] - p[1]) - (p[4] - p[0]) * (y - p[1])) / det;
+            float wc = ((p[2] - p[0]) * (y - p[1]) - (x - p[0]) * (p[3] - p[1])) / det;
+            rule.w[m][v][0] = 1.0f - wb - wc;
+            rule.w[m][v][1] = wb;
+            rule.w[m][v][2] = wc;
+        }
+    }
+    return rule;
+}
+
+//vectors of floats the kernels are written for besides plain floats, see ifsSubdivideRange
+//the helpers below only ever take and hand back vectors by reference: with AVX off in the rest of
+//the file, passing a 32 byte vector by value has no fixed ABI and GCC warns about it (-Wpsabi)
+#if defined(__GNUC__)
+typedef float ifs_v4sf __attribute__((vector_size(16)));
+typedef float ifs_v8sf __attribute__((vector_size(32)));
+#endif
+
+/**
+ * One coordinate of corner V of child M, with the weights of the rule folded in. Weights of 0
+ * are left out and sums of two equal weights are done as (p + q) * w, so the Sierpinski Triangle
+ * comes down to the same midpoints as subdivideScalar
+ * @param out set to the coordinate of the corner
+ * @param a the coordinate of the parent's first corner
+ * @param b the coordinate of its second corner
+ * @param c the coordinate of its third corner
+*/
+template<int MapCount, const SubdivisionRule<MapCount> &Rule, int M, int V, typename T>
+static inline __attribute__((always_inline)) void ifsCorner(T &out, const T &a, const T &b, const T &c){
+    constexpr float wa = Rule.w[M][V][0], wb = Rule.w[M][V][1], wc = Rule.w[M][V][2];
+    if constexpr(wb == 0.0f && wc == 0.0f){
+        if constexpr(wa == 1.0f) out = a; else out = a * wa;
+    } else if constexpr(wa == 0.0f && wc == 0.0f){
+        if constexpr(wb == 1.0f) out = b; else out = b * wb;
+    } else if constexpr(wa == 0.0f && wb == 0.0f){
+        if constexpr(wc == 1.0f) out = c; else out = c * wc;
+    } else if constexpr(wc == 0.0f){
+        if constexpr(wa == wb) out = (a + b) * wa; else out = a * wa + b * wb;
+    } else if constexpr(wb == 0.0f){
+        if constexpr(wa == wc) out = (a + c) * wa; else out = a * wa + c * wc;
+    } else if constexpr(wa == 0.0f){
+        if constexpr(wb == wc) out = (b + c) * wb; else out = b * wb + c * wc;
+    } else{
+        out = a * wa + b * wb + c * wc;
+    }
+}
+
+/**
+ * Loads one lane's worth of floats from a possibly unaligned address
+ * @param v set to the floats at p
+*/
+template<typename T>
+static inline __attribute__((always_inline)) void ifsLoad(T &v, const float *p){
+    memcpy(&v, p, sizeof(T));
+}
+
+/**
+ * Stores one lane's worth of floats to a possibly unaligned address
+*/
+template<typename T>
+static inline __attribute__((always_inline)) void ifsStore(float *p, const T &v){
+    memcpy(p, &v, sizeof(T));
+}
+
+/**
+ * Writes child M of a group of parents
+ * @param children the triangles to write the children to
+ * @param i the first parent of the group
+ * @param n the number of parents in the level
+*/
+template<int MapCount, const SubdivisionRule<MapCount> &Rule, int M, typename T>
+static inline __attribute__((always_inline)) void ifsChild(triangles_t &children, size_t i, size_t n,
+                                                            const T &ax, const T &ay, const T &bx,
+                                                            const T &by, const T &cx, const T &cy){
+    size_t j = M * n + i;
+    T v;
+    ifsCorner<MapCount, Rule, M, 0>(v, ax, bx, cx);
+    ifsStore(children.ax + j, v);
+    ifsCorner<MapCount, Rule, M, 0>(v, ay, by, cy);
+    ifsStore(children.ay + j, v);
+    ifsCorner<MapCount, Rule, M, 1>(v, ax, bx, cx);
+    ifsStore(children.bx + j, v);
+    ifsCorner<MapCount, Rule, M, 1>(v, ay, by, cy);
+    ifsStore(children.by + j, v);
+    ifsCorner<MapCount, Rule, M, 2>(v, ax, bx, cx);
+    ifsStore(children.cx + j, v);
+    ifsCorner<MapCount, Rule, M, 2>(v, ay, by, cy);
+    ifsStore(children.cy + j, v);
+}
+
+/**
+ * Writes every child of a group of parents, the group being as many parents as T holds floats
+*/
+template<int MapCount, const SubdivisionRule<MapCount> &Rule, typename T, int... M>
+static inline __attribute__((always_inline)) void ifsChildren(const triangles_t &parents, triangles_t &children,
+                                                               size_t i, std::integer_sequence<int, M...>){
+    const size_t n = parents.count;
+    T ax, ay, bx, by, cx, cy;
+    ifsLoad(ax, parents.ax + i);
+    ifsLoad(ay, parents.ay + i);
+    ifsLoad(bx, parents.bx + i);
+    ifsLoad(by, parents.by + i);
+    ifsLoad(cx, parents.cx + i);
+    ifsLoad(cy, parents.cy + i);
+    (ifsChild<MapCount, Rule, M>(children, i, n, ax, ay, bx, by, cx, cy), ...);
+}
+
+/**
+ * Subdivides parents 'begin' up to 'end', sizeof(T) / sizeof(float) at a time
+ * @return the first parent left over because there were not enough for a whole T
+*/
+template<int MapCount, const SubdivisionRule<MapCount> &Rule, typename T>
+static inline __attribute__((always_inline)) size_t ifsSubdivideRange(const triangles_t &parents, triangles_t &children,
+                                                                       size_t begin, size_t end){
+    const size_t lanes = sizeof(T) / sizeof(float);
+    size_t i = begin;
+    for(; i + lanes <= end; i += lanes){
+        ifsChildren<MapCount, Rule, T>(parents, children, i, std::make_integer_sequence<int, MapCount>());
+    }
+    return i;
+}
+
+/**
+ * Builds the next depth level of an IFS fractal out of a level of triangles, one triangle at a time
+ * @param parents the triangles to subdivide
+ * @param children the triangles to write the children to
+ * pre: children has room for MapCount * parents.count triangles, and does not overlap parents
+ * post: children.count == MapCount * parents.count
+*/
+template<int MapCount, const SubdivisionRule<MapCount> &Rule>
+void subdivideIFSScalar(const triangles_t &parents, triangles_t &children){
+    ifsSubdivideRange<MapCount, Rule, float>(parents, children, 0, parents.count);
+    children.count = MapCount * parents.count;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__ARM_NEON))
+/**
+ * subdivideIFSScalar, 4 triangles at a time (SSE on x86-64, NEON on ARM)
+*/
+template<int MapCount, const SubdivisionRule<MapCount> &Rule>
+void subdivideIFS4(const triangles_t &parents, triangles_t &children){
+    size_t i = ifsSubdivideRange<MapCount, Rule, ifs_v4sf>(parents, children, 0, parents.count);
+    ifsSubdivideRange<MapCount, Rule, float>(parents, children, i, parents.count);
+    children.count = MapCount * parents.count;
+}
+#define IFS_VECTOR4
+#endif
+
+#ifdef SUBDIVIDE_X86
+/**
+ * subdivideIFSScalar, 8 triangles at a time with AVX2
+ * pre: the CPU supports AVX2
+*/
+template<int MapCount, const SubdivisionRule<MapCount> &Rule>
+__attribute__((target("avx2")))
+void subdivideIFSAVX2(const triangles_t &parents, triangles_t &children){
+    size_t i = ifsSubdivideRange<MapCount, Rule, ifs_v8sf>(parents, children, 0, parents.count);
+    ifsSubdivideRange<MapCount, Rule, float>(parents, children, i, parents.count);
+    children.count = MapCount * parents.count;
+}
+#endif
+
+/**
+ * Picks the fastest kernel of an IFS the CPU supports, like subdivideKernel does for the Sierpinski Triangle
+ * @return the kernel to subdivide with
+*/
+template<int MapCount, const SubdivisionRule<MapCount> &Rule>
+subdivide_kernel_t subdivideIFSKernel(){
+#ifdef SUBDIVIDE_X86
+    if(__builtin_cpu_supports("avx2")){
+        return subdivideIFSAVX2<MapCount, Rule>;
+    }
+#endif
+#ifdef IFS_VECTOR4
+    return subdivideIFS4<MapCount, Rule>;
+#else
+    return subdivideIFSScalar<MapCount, Rule>;
+#endif
+}
+
+#endif
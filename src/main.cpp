@@ -4,86 +4,936 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stddef.h>
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
 #include "shader.h"
 #include "mytypes.h"
+#include "subdivide.h"
+#include "sierpinski.h"
+#include "streambuffer.h"
+#include "profiler.h"
+#include "overlay.h"
+#include "geometrycache.h"
+#include "spscqueue.h"
+#include "framepacer.h"
 
-#define MAX_SIERPINSKI_DEPTH 8      //change this to allow for more recursive depth for
-                                    // Sierpinski's Triangle
+#define DEFAULT_SIERPINSKI_DEPTH 8  //recursive depth used when none is given with --depth
+#define STREAM_SLOTS 2              //slots in the stream buffer: one drawn from, one being regenerated
+#define SHADER_RELOAD_INTERVAL 0.5  //seconds between checks for edited shader files
+#define MAX_ZOOM 1099511627776.0    //deepest magnification of RENDER_ZOOM (2^40), double positions run out of bits after it
+#define ZOOM_MARGIN 2.0             //RENDER_ZOOM builds geometry for this many times the view's extent
+#define ZOOM_REBUILD_RATIO 1.5      //RENDER_ZOOM rebuilds once the zoom changed by this factor
+#define OVERLAY_INTERVAL 0.25       //seconds between updates of the frame timing overlay
+#define OVERLAY_PIXEL 2             //size of a font pixel of the overlay, in framebuffer pixels
+#define DEFAULT_BENCHMARK_FRAMES 200   //frames drawn per depth by --benchmark when none is given with --frames
+#define DEFAULT_CHAOS_POINTS 1000000   //points RENDER_CHAOS adds every frame when none is given with --points
+#define DEFAULT_UPLOAD_BUDGET 16     //megabytes --progressive uploads per frame when none is given with --upload-budget
+#define PROGRESSIVE_CHUNK 16384     //most triangles the --progressive worker hands over at once
+#define PROGRESSIVE_QUEUE_SLOTS 256 //chunks the --progressive worker can be ahead of the uploads
+#define DEFAULT_EXPORT_TILE 2048    //size of the tiles --export renders the image in when none is given with --tile
+#define BACKGROUND_DEPTH 0.99       //window depth the background is drawn at when depth tested, behind every level
+
+/**
+ * The ways we can send the Sierpinski Triangle to the GPU
+ * RENDER_VERTICES: every sub-triangle gets its own 3 vertices in the VBO
+ * RENDER_PACKED: like RENDER_VERTICES, but with 8 byte packed_vertex_t vertices whose color
+ *                is worked out in the vertex shader
+ * RENDER_INDEXED: every vertex is stored once per depth level, and an EBO lists the 3 vertices
+ *                 of each sub-triangle
+ * RENDER_INSTANCED: one unit triangle is drawn once per sub-triangle, using a per-instance
+ *                   offset, scale and depth
+ * RENDER_GENERATED: nothing is uploaded, the vertex shader works out every vertex from gl_VertexID
+ * RENDER_ZOOM: only the sub-triangles around the view, down to pixel size, are built on the CPU
+ *              and uploaded whenever the view moves out of them
+ * RENDER_PROCEDURAL: no geometry at all, the fragment shader tests every pixel of the background
+ *                    rectangle for the levels of the triangle that cover it
+ * RENDER_CHAOS: no mesh at all, a batch of chaos game points is streamed every frame and drawn as
+ *               GL_POINTS into a float buffer that adds them up, so the triangle fills in over time
+*/
+enum RenderMode{
+    RENDER_VERTICES,
+    RENDER_PACKED,
+    RENDER_INDEXED,
+    RENDER_INSTANCED,
+    RENDER_GENERATED,
+    RENDER_ZOOM,
+    RENDER_PROCEDURAL,
+    RENDER_CHAOS
+};
+
+/**
+ * How finished frames are presented
+ * PRESENT_VSYNC: wait for the display's refresh before every swap
+ * PRESENT_ADAPTIVE: like PRESENT_VSYNC, but a frame that misses its refresh is swapped right away
+ *                   and tears, instead of waiting for the next one (swap-control-tear)
+ * PRESENT_UNCAPPED: swap as soon as a frame is drawn, to see how fast we can go
+ * PRESENT_EVENTS: like PRESENT_VSYNC, but frames are only drawn when something changed (input,
+ *                 resizes, geometry being built, animations) and the loop sleeps in between
+*/
+enum PresentMode{
+    PRESENT_VSYNC,
+    PRESENT_ADAPTIVE,
+    PRESENT_UNCAPPED,
+    PRESENT_EVENTS
+};
+
+/**
+ * What part of the Sierpinski Triangle is shown, changed with the mouse wheel and by dragging
+ * centerX/centerY: the point of the triangle at the middle of the window
+ * zoom: how many times the triangle is magnified, 1 shows it whole as the other modes do
+*/
+struct View{
+    double centerX = 0.0;
+    double centerY = 0.0;
+    double zoom = 1.0;
+};
+
+/**
+ * State of a Sierpinski Triangle being generated on a worker thread
+ * worker: the thread running the generation
+ * done: set by the worker once the geometry is finished
+ * running: true from the moment the worker is started until its result has been collected
+ * depth: the depth being generated
+ * slot: the stream buffer slot the geometry is written into (RENDER_VERTICES, RENDER_PACKED,
+ *       RENDER_INSTANCED)
+ * target: mapped memory of that slot, the generators write straight into it
+ * vertices: the generated vertex data (RENDER_INDEXED), reused between builds so its
+ *           memory is only grown
+ * indices: the generated element data (RENDER_INDEXED), reused the same way
+*/
+struct GeometryBuild{
+    std::thread worker;
+    std::atomic<bool> done{false};
+    bool running = false;
+    int depth = 0;
+    int slot = 0;
+    void *target = NULL;
+    std::vector<vertex_t> vertices;
+    std::vector<unsigned int> indices;
+};
+
+/**
+ * A run of vertices written by the worker of a ProgressiveBuild, ready to be uploaded
+ * level: the depth level the vertices belong to
+ * first: the first vertex of the run
+ * count: the number of vertices in the run, a multiple of 3
+*/
+struct GeometryChunk{
+    int level;
+    size_t first;
+    size_t count;
+};
+
+/**
+ * State of a triangle built progressively (--progressive). A worker thread writes the vertices front
+ * to back into 'staging' and hands every chunk it finishes to the render thread through 'queue'. The
+ * render thread uploads at most uploadBudget bytes of them per frame, and draws what is uploaded so
+ * far, so the first frame doesn't wait for the whole triangle and the window stays responsive.
+ * worker: the thread writing the vertices
+ * running: true from the moment the worker is started until it has been joined
+ * done: set by the worker once it wrote every vertex, or gave up because of 'cancel'
+ * cancel: set to make the worker stop early
+ * depth: the depth being built
+ * vertexCount: the number of vertices of the whole triangle
+ * vertexSize: the size of one vertex in the current render mode
+ * staging: memory the worker writes the vertices into, only grown
+ * stagingSize: the size of 'staging' in bytes
+ * queue: chunks written by the worker and not taken by the render thread yet
+ * pending: the chunk being uploaded, which may take several frames
+ * pendingUploaded: the number of vertices of 'pending' already uploaded
+ * uploaded: the number of vertices uploaded so far, always a prefix of the triangle
+*/
+struct ProgressiveBuild{
+    std::thread worker;
+    bool running = false;
+    std::atomic<bool> done{false};
+    std::atomic<bool> cancel{false};
+    int depth = 0;
+    size_t vertexCount = 0;
+    size_t vertexSize = 0;
+    std::unique_ptr<unsigned char[]> staging;
+    size_t stagingSize = 0;
+    SPSCQueue<GeometryChunk, PROGRESSIVE_QUEUE_SLOTS> queue;
+    GeometryChunk pending = {0, 0, 0};
+    size_t pendingUploaded = 0;
+    size_t uploaded = 0;
+};
+
+/**
+ * State of a triangle refined one level at a time (--incremental, RENDER_PACKED and RENDER_INSTANCED).
+ * The VBO keeps every level built so far, so lowering the depth only draws fewer of them, and raising
+ * it again up to builtDepth just draws more. Deeper levels are built from 'frontier' on a worker thread
+ * and appended to the VBO with glBufferSubData, so every step only costs the triangles it adds. When
+ * the VBO is too small for them it is replaced by a larger one, and the levels already in it are
+ * copied over on the GPU with glCopyBufferSubData instead of being built or uploaded again.
+ * This only works for the modes that work out the colors on the GPU, since RENDER_VERTICES bakes the
+ * depth of the whole triangle into the color of every vertex.
+ * worker: the thread building the new levels
+ * running: true from the moment the worker is started until its levels have been uploaded
+ * done: set by the worker once every new level is written to 'staging'
+ * frontier: the deepest level built, which the next levels are made from
+ * builtDepth: the deepest level held by the VBO, -1 if it is empty
+ * targetDepth: the deepest level the worker is building
+ * staging: the vertices (or instances) of the levels the worker is building, only grown
+ * capacity: the size of the VBO in bytes
+*/
+struct IncrementalGeometry{
+    std::thread worker;
+    bool running = false;
+    std::atomic<bool> done{false};
+    fractal_frontier_t frontier;
+    int builtDepth = -1;
+    int targetDepth = -1;
+    std::vector<unsigned char> staging;
+    size_t capacity = 0;
+};
+
+/**
+ * The triangle as the main thread last drew it, handed to the render threads of --wall
+ * version: bumped every time the triangle moves to another buffer or depth
+ * buffer: the buffer object the triangle is drawn from
+ * slot: the stream buffer slot 'buffer' belongs to
+ * depth: the depth of the triangle
+ * ready: fence behind the main thread's commands filling 'buffer', waited on before drawing from it
+ * backgroundProgram: the program the background is drawn with
+ * triangleProgram: the program the triangle is drawn with, both being whatever hot reload last swapped in
+*/
+struct WallScene{
+    unsigned long version = 0;
+    unsigned int buffer = 0;
+    int slot = -1;
+    int depth = -1;
+    GLsync ready = 0;
+    unsigned int backgroundProgram = 0;
+    unsigned int triangleProgram = 0;
+};
+
+/**
+ * A window of --wall on a monitor other than the main window's, drawn into by a thread of its own
+ * window: the full screen window, its context sharing objects with the main one
+ * thread: the render thread drawing into it, and presenting with its own vsync (see wallFollowsMainLoop)
+ * width, height: the size of its framebuffer, only GLFW's main thread may look it up
+*/
+struct WallWindow{
+    GLFWwindow *window = NULL;
+    std::thread thread;
+    std::atomic<int> width{0};
+    std::atomic<int> height{0};
+};
+
+/**
+ * State of --wall: one full screen window per monitor, all drawing the one triangle of the main
+ * window. The contexts share their objects with the main one, so the triangle is only generated
+ * and uploaded once, and only the VAOs (which can't be shared) are made per window.
+ * The uniforms are only ever set by the main thread, and the render threads bind the programs
+ * again every frame to pick them up.
+ * windows: the windows besides the main one
+ * mutex: guards 'scene' and 'frame'
+ * scene: what the render threads draw
+ * frame: the number of frames the main thread presented, render threads following the main loop
+ *        draw one frame every time it goes up
+ * framePresented: signalled every time 'frame' goes up, and when the wall stops
+ * readers: the number of render threads drawing from each stream buffer slot, which the main
+ *          thread must not write into until it drops to 0
+ * stop: set to make the render threads finish
+*/
+struct Wall{
+    std::vector<std::unique_ptr<WallWindow>> windows;
+    std::mutex mutex;
+    WallScene scene;
+    unsigned long frame = 0;
+    std::condition_variable framePresented;
+    std::atomic<int> readers[STREAM_SLOTS] = {};
+    std::atomic<bool> stop{false};
+};
+
+/**
+ * State of the shader hot reload: edited shader files are rebuilt on a worker thread, on a hidden
+ * context that shares objects with the main one, then swapped in by the render loop
+ * context: the hidden window whose context the worker builds on, NULL to build on the main thread
+ * worker: the thread building the program
+ * done: set by the worker once program has been built
+ * running: true from the moment the worker is started until its program has been swapped in
+ * shader: the shader being rebuilt
+ * program: the program built by the worker, 0 if it failed to build
+ * lastCheck: glfwGetTime() of the last check for edited files
+*/
+struct ShaderReload{
+    GLFWwindow *context = NULL;
+    std::thread worker;
+    std::atomic<bool> done{false};
+    bool running = false;
+    Shader *shader = NULL;
+    unsigned int program = 0;
+    double lastCheck = 0.0;
+};
+
+/**
+ * Geometry of RENDER_ZOOM, built around a view and reused as long as the view stays inside it.
+ * Its positions are relative to the view it was built for: (p - built.center) * built.zoom, so
+ * they stay small enough for floats however deep the view is
+ * built: the view the geometry was built for
+ * valid: false until the geometry has been built once
+ * deepest: the deepest level in the geometry
+ * vertices: the visible triangles, level by level, reused between builds so its memory is only grown
+ * scratch: the triangles of the level being subdivided and of the level after it
+ * tiles: the same in double precision, for the levels larger than the view
+*/
+struct ZoomGeometry{
+    View built;
+    bool valid = false;
+    int deepest = 0;
+    std::vector<vertex_t> vertices;
+    std::vector<float> scratch[2];
+    std::vector<dtriangle_t> tiles[2];
+};
+
+/**
+ * The float buffer RENDER_CHAOS adds its points up in, as hits per pixel
+ * FBO: the framebuffer the points are drawn into
+ * texture: the R32F texture holding the hits, the size of the window's framebuffer
+ * width, height: the size of 'texture', 0 until it is created
+ * valid: false if 'texture' could not be drawn into at that size
+ * points: how many points were added up so far
+ * walkers: the walks of the chaos game, one per generating thread
+ * pool: the generating threads, kept from frame to frame, NULL until the walkers are seeded
+*/
+struct ChaosAccumulation{
+    unsigned int FBO = 0;
+    unsigned int texture = 0;
+    int width = 0;
+    int height = 0;
+    bool valid = false;
+    double points = 0.0;
+    std::vector<chaos_walker_t> walkers;
+    std::unique_ptr<WorkerPool> pool;
+};
+
+/**
+ * State of a --benchmark run, which draws benchmarkFrames frames at every depth of a sweep
+ * depth: the depth being benchmarked
+ * frame: frames drawn at that depth so far
+ * start: glfwGetTime() when the first frame at that depth started
+ * generateMs: time it took to generate the geometry of that depth
+ * uploadMs: time it took to hand that geometry to the GPU, up to glFinish
+*/
+struct Benchmark{
+    int depth = 0;
+    int frame = 0;
+    double start = 0.0;
+    double generateMs = 0.0;
+    double uploadMs = 0.0;
+};
+
+/**
+ * State of an --export run, which draws a large image one tile at a time and writes it to a PPM.
+ * Tiles are drawn row by row from the top of the image, into an offscreen framebuffer of
+ * tileSize x tileSize pixels. Each tile is read back into one of two PBOs by an asynchronous
+ * glReadPixels, and only mapped once the next tile was drawn, so the readback overlaps drawing.
+ * Mapped tiles are copied into the band of image rows they belong to, and every finished band is
+ * written to the file on a worker thread while the next one is filled.
+ * file: the PPM being written
+ * width, height: size of the image in pixels
+ * tileSize: size of the tiles in pixels, the last row and column of tiles may be smaller
+ * tilesX, tilesY: number of tiles across and down the image
+ * next: the next tile to draw, counting row by row from the top left
+ * pbo: the pixel pack buffers tiles are read back into, tile i uses pbo[i % 2]
+ * bands: the band being filled (bands[0]) and the one being written (bands[1]), tileSize rows each
+ * writer: the thread writing bands[1]
+ * running: true while writer has to be joined
+ * failed: set by the writer if the file could not be written
+ * tileFBO: the offscreen framebuffer the tiles are drawn into
+ * resolveFBO, resolveRBO: single sampled framebuffer a multisampled tile is resolved into before it
+ *                         is read back, 0 without --msaa
+*/
+struct ImageExport{
+    FILE *file = NULL;
+    int width = 0;
+    int height = 0;
+    int tileSize = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    int next = 0;
+    unsigned int pbo[2] = {0, 0};
+    std::vector<unsigned char> bands[2];
+    std::thread writer;
+    bool running = false;
+    std::atomic<bool> failed{false};
+    unsigned int tileFBO = 0;
+    unsigned int resolveFBO = 0;
+    unsigned int resolveRBO = 0;
+};
+
+/**
+ * Everything the render loop needs to draw an object, cached when its geometry is built so
+ * drawing never has to query OpenGL state
+ * VAO/VBO: ids of the vertex array object and its vertex buffer, 0 if not generated yet
+ * EBO: id of the element buffer the draw reads GL_UNSIGNED_INT indices from, 0 for a non-indexed draw
+ * count: number of vertices (or indices, if indexed) drawn, per instance if instanced
+ * instanceCount: number of instances drawn, 0 for a non-instanced draw
+ * primitive: the primitive the vertices are assembled into
+ * depth: depth of the Sierpinski Triangle held in the buffers, -1 if none
+*/
+struct Renderable{
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    int count = 0;
+    int instanceCount = 0;
+    unsigned int primitive = GL_TRIANGLES;
+    int depth = -1;
+};
+
+int parseArgs(int argc, char **argv);
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void cursor_callback(GLFWwindow* window, double x, double y);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void refresh_callback(GLFWwindow* window);
+int presentSwapInterval();
+void waitForRedraw(GLFWwindow *window, ShaderReload &reload, Shader *const *shaders, int shaderCount);
 void processInput(GLFWwindow *window);
-void addSierpinskiPts(point_t a, point_t b, point_t c, int depth, std::vector<float>& points);
-void initSierpinski(std::vector<float> &points);
-void sierpinskiOpenGLObj(unsigned int &VAO, unsigned int &VBO);
+bool zoomNeedsRebuild(const ZoomGeometry &geometry, const View &view);
+void initSierpinskiView(ZoomGeometry &geometry, const View &view);
+size_t streamedGeometrySize(int depth);
+bool prepareGeometryBuild(GeometryBuild &build, StreamBuffer &stream, int slot, int depth);
+void generateGeometry(GeometryBuild &build);
+bool cachedGeometry(GeometryBuild &build);
+void startGeometryBuild(GeometryBuild &build);
+bool finishGeometryBuild(GeometryBuild &build);
+bool uploadGeometry(Renderable &tri, GeometryBuild &build, StreamBuffer &stream, unsigned int meshVBO);
+bool loadGeometryNow(GeometryBuild &build, StreamBuffer &stream, Renderable *tri, int &front,
+                     unsigned int meshVBO, int depth, double *generateMs, double *uploadMs);
+void startProgressiveBuild(ProgressiveBuild &progressive, Renderable &tri, int depth);
+void uploadProgressiveBuild(ProgressiveBuild &progressive, Renderable &tri, size_t budget);
+void stopProgressiveBuild(ProgressiveBuild &progressive);
+void startIncrementalBuild(IncrementalGeometry &incremental, Renderable &tri, int depth);
+bool finishIncrementalBuild(IncrementalGeometry &incremental, Renderable &tri, unsigned int meshVBO);
+void showIncrementalDepth(Renderable &tri, int depth);
+void pollShaderReload(ShaderReload &reload, Shader *const *shaders, int shaderCount);
+int visibleDepth(int depth);
+int visibleDepth(int depth, int width, int height);
+int maxFractalDepth();
+void drawRenderable(const Renderable &obj, int depth);
+void drawRenderableFrontToBack(const Renderable &obj, int depth);
+bool fillVertexBuffer(Renderable &obj, const void *data, size_t size);
+void vertexAttributes();
+void packedVertexAttributes();
+void instanceAttributes(unsigned int instanceVBO, unsigned int meshVBO);
+void sierpinskiOpenGLObj(Renderable &tri, const std::vector<vertex_t> &vertices, int depth);
+void fillElementBuffer(Renderable &obj, const std::vector<unsigned int> &indices);
+void sierpinskiIndexedOpenGLObj(Renderable &tri, const std::vector<vertex_t> &vertices,
+                                const std::vector<unsigned int> &indices, int depth);
+void unitTriangleOpenGLObj(unsigned int &VBO);
+void sierpinskiStreamedOpenGLObj(Renderable &tri, unsigned int buffer, unsigned int meshVBO, int depth);
+void sierpinskiGeneratedOpenGLObj(Renderable &tri, int depth);
+void chaosPointsOpenGLObj(Renderable &points, unsigned int buffer, int count);
+bool chaosAccumulationOpenGLObj(ChaosAccumulation &chaos, int width, int height);
+void overlayOpenGLObj(Renderable &overlay, std::vector<vertex_t> &vertices, const FrameProfiler &profiler);
 void backgroundOpenGLObj(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO);
-GLFWwindow* glfwOpenGLInit();
+void backgroundAttributes(unsigned int VBO, unsigned int EBO);
+unsigned int offscreenFramebuffer(int width, int height, int samples, unsigned int &colorRBO, unsigned int *depthRBO);
+bool beginImageExport(ImageExport &image, const char *path, int width, int height, int tileSize);
+void imageTileRect(const ImageExport &image, int tile, int &x, int &y, int &w, int &h);
+vec4_t beginImageTile(const ImageExport &image);
+void collectImageTile(ImageExport &image, int tile);
+void writeImageBand(ImageExport &image, int rows);
+void endImageTile(ImageExport &image);
+bool finishImageExport(ImageExport &image);
+GLFWwindow* glfwOpenGLInit(bool visible);
+GLFWwindow* glfwSharedContextInit(GLFWwindow *window);
+int glfwWallInit(GLFWwindow *window, Wall &wall);
+void startWallThreads(Wall &wall, unsigned int bgVBO, unsigned int bgEBO, unsigned int meshVBO);
+void wallRenderLoop(Wall &wall, WallWindow &target, unsigned int bgVBO, unsigned int bgEBO, unsigned int meshVBO);
+void publishWallScene(Wall &wall, const Renderable &tri, int slot, unsigned int backgroundProgram,
+                      unsigned int triangleProgram);
+void presentWallFrame(Wall &wall);
+bool wallFollowsMainLoop();
+bool wallDrawingFrom(const Wall &wall, int slot);
+bool pollWallWindows(Wall &wall);
+void stopWall(Wall &wall);
 
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 800;
 
+int sierpinskiDepth = DEFAULT_SIERPINSKI_DEPTH;    //depth requested through --depth or the +/- keys
+RenderMode renderMode = RENDER_VERTICES;            //chosen with --packed, --indexed, --instanced, --generated, --zoom,
+                                                    //--procedural or --chaos
+int generatorThreads = 0;                           //threads generating geometry, 0 = one per core
+int framebufferWidth = SCR_WIDTH;                   //size of the framebuffer in pixels, kept up to date
+int framebufferHeight = SCR_HEIGHT;                 //by framebuffer_size_callback
+View view;                                          //part of the triangle shown by RENDER_ZOOM
+bool showOverlay = false;                           //frame timing overlay, --overlay or F1
+const char *profileLogPath = NULL;                  //file every frame's timing is logged to, --profile-log
+bool benchmarkMode = false;                         //--benchmark: hidden window, fixed frames, depth sweep
+int benchmarkFrames = DEFAULT_BENCHMARK_FRAMES;     //frames per depth, --frames
+int benchmarkMinDepth = 0;                          //depths swept, --benchmark-depths
+int benchmarkMaxDepth = 10;
+int benchmarkWidth = 1920;                          //offscreen framebuffer size, --resolution
+int benchmarkHeight = 1080;
+const char *exportPath = NULL;                      //--export: PPM the triangle is drawn to instead of a window
+int exportWidth = 16384;                            //size of the exported image, --export-size
+int exportHeight = 16384;
+int exportTile = DEFAULT_EXPORT_TILE;               //size of the tiles it is drawn in, --tile
+int chaosPoints = DEFAULT_CHAOS_POINTS;             //points RENDER_CHAOS adds every frame, --points
+const fractal_t *fractal = &SIERPINSKI_FRACTAL;     //fractal RENDER_VERTICES and RENDER_PACKED build, --fractal
+const char *cacheDir = NULL;                        //directory generated geometry is cached in, --cache
+bool progressiveMode = false;                       //--progressive: build in the background and draw as it arrives
+size_t uploadBudget = (size_t)DEFAULT_UPLOAD_BUDGET << 20;  //bytes --progressive uploads per frame, --upload-budget
+bool incrementalMode = false;                       //--incremental: change the depth by adding or dropping levels
+bool wallMode = false;                              //--wall: a full screen window on every monitor
+PresentMode presentMode = PRESENT_VSYNC;            //chosen with --present
+double frameLimit = 0.0;                            //frames per second the loop is held to, --fps, 0 for no limit
+bool redrawRequested = true;                        //set by the input and window callbacks, see PRESENT_EVENTS
+bool depthTest = true;                              //draw the mesh deepest level first with the depth test, --no-depth-test
+int msaaSamples = 0;                                //samples per pixel of the framebuffer drawn into, --msaa, 0 for none
+
 
 /**
  * Entry point of the program, also where the main logic of rendering takes place
+ * @param argc the number of command line arguments
+ * @param argv the command line arguments, see parseArgs for the ones we accept
 */
-int main()
+int main(int argc, char **argv)
 {
-    GLFWwindow *window = glfwOpenGLInit();
+    if(parseArgs(argc, argv) != 0){
+        return -1;
+    }
+
+    //the benchmark and the export draw into an offscreen framebuffer, so they don't show their window
+    GLFWwindow *window = glfwOpenGLInit(!benchmarkMode && exportPath == NULL);
     if(window == NULL){
         return -1;
     }
+    Wall wall;
+    if(wallMode){
+        glfwWallInit(window, wall);
+    }
+    unsigned int offscreenFBO = 0, offscreenRBO = 0, offscreenDepthRBO = 0;
+    Benchmark bench;
+    ImageExport image;
+    if(benchmarkMode){
+        glfwSwapInterval(0);    //measure how fast we can draw, not the refresh rate
+        offscreenFBO = offscreenFramebuffer(benchmarkWidth, benchmarkHeight, msaaSamples, offscreenRBO, &offscreenDepthRBO);
+        if(offscreenFBO == 0){
+            glfwTerminate();
+            return -1;
+        }
+        framebufferWidth = benchmarkWidth;
+        framebufferHeight = benchmarkHeight;
+        glViewport(0, 0, benchmarkWidth, benchmarkHeight);
+        bench.depth = benchmarkMinDepth;
+        sierpinskiDepth = bench.depth;
+        printf("depth,drawn_depth,vertices,generate_ms,upload_ms,frames,fps\n");
+    } else if(exportPath != NULL){
+        glfwSwapInterval(0);    //nothing is shown, so don't wait for the display between tiles
+        int maxSize = 0;
+        glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+        exportTile = std::min(exportTile, maxSize);
+        if(msaaSamples > 0){
+            image.resolveFBO = offscreenFramebuffer(exportTile, exportTile, 0, image.resolveRBO, NULL);
+        }
+        offscreenFBO = offscreenFramebuffer(exportTile, exportTile, msaaSamples, offscreenRBO, &offscreenDepthRBO);
+        image.tileFBO = offscreenFBO;
+        if(offscreenFBO == 0 || (msaaSamples > 0 && image.resolveFBO == 0)
+           || !beginImageExport(image, exportPath, exportWidth, exportHeight, exportTile)){
+            glfwTerminate();
+            return -1;
+        }
+        //pick the depths to draw for the whole image, not for one tile
+        framebufferWidth = exportWidth;
+        framebufferHeight = exportHeight;
+        showOverlay = false;
+    } else{
+        int interval = presentSwapInterval();
+        if(presentMode == PRESENT_ADAPTIVE && interval != -1){
+            printf("Adaptive vsync is not supported by the driver, using vsync\n");
+        }
+        glfwSwapInterval(interval);
+    }
 
     Shader myShader("VertexShader.glsl", "FragmentShader.glsl");
+    Shader packedShader("PackedVertexShader.glsl", "FragmentShader.glsl");
+    Shader instancedShader("InstancedVertexShader.glsl", "FragmentShader.glsl");
+    Shader generatedShader("GeneratedVertexShader.glsl", "FragmentShader.glsl");
+    Shader zoomShader("ZoomVertexShader.glsl", "FragmentShader.glsl");
+    Shader proceduralShader("ProceduralVertexShader.glsl", "ProceduralFragmentShader.glsl");
+    Shader chaosShader("ChaosVertexShader.glsl", "ChaosFragmentShader.glsl");
+    Shader chaosDisplayShader("ChaosVertexShader.glsl", "ChaosDisplayFragmentShader.glsl");
+    //uniforms set every frame, looked up once here
+    Uniform<int> packedMaxDepth = packedShader.uniform<int>("maxDepth");
+    Uniform<vec3_t> packedPalette = packedShader.uniform<vec3_t>("palette");
+    Uniform<float> instancedMaxDepth = instancedShader.uniform<float>("maxDepth");
+    Uniform<int> generatedMaxDepth = generatedShader.uniform<int>("maxDepth");
+    Uniform<vec2_t> zoomOffset = zoomShader.uniform<vec2_t>("viewOffset");
+    Uniform<float> zoomScale = zoomShader.uniform<float>("viewScale");
+    Uniform<int> proceduralMaxDepth = proceduralShader.uniform<int>("maxDepth");
+    Uniform<int> proceduralDrawDepth = proceduralShader.uniform<int>("drawDepth");
+    Uniform<vec4_t> proceduralTile = proceduralShader.uniform<vec4_t>("tile");
+    Uniform<float> chaosExposure = chaosDisplayShader.uniform<float>("exposure");
+    Uniform<vec4_t> vertexTile = myShader.uniform<vec4_t>("tile");
+    Uniform<vec4_t> packedTile = packedShader.uniform<vec4_t>("tile");
+    Uniform<vec4_t> instancedTile = instancedShader.uniform<vec4_t>("tile");
+    Uniform<vec4_t> generatedTile = generatedShader.uniform<vec4_t>("tile");
+    vec4_t tile = {1.0f, 1.0f, 0.0f, 0.0f};     //part of the image being drawn, all of it unless exporting
+    const vec3_t palette[] = {
+        {0.25f, 0.0f, 0.75f},   //color of the outer triangle
+        {0.25f, 1.0f, 0.75f}    //color of the deepest level
+    };
+    //edited shader files are rebuilt in the background, without touching any geometry
+    //a rebuilt program starts with its uniforms at 0, which is why the render loop sets all of them every frame
+    Shader *shaders[] = {&myShader, &packedShader, &instancedShader, &generatedShader, &zoomShader,
+                         &proceduralShader, &chaosShader, &chaosDisplayShader};
+    ShaderReload reload;
+    reload.context = glfwSharedContextInit(window);
 
-    unsigned int triVAO, triVBO;
-    sierpinskiOpenGLObj(triVAO, triVBO);
+    //one renderable per stream buffer slot: we draw from the front one while a regenerated
+    //triangle is written straight into the mapped memory of the next slot by the worker thread
+    //in RENDER_INSTANCED the slots hold the per-instance data, and meshVBO the unit triangle
+    //in RENDER_INDEXED the renderables own their buffers, and are refilled with glBufferData
+    //in RENDER_GENERATED only tri[0] is used, and it has no buffers at all
+    //in RENDER_PROCEDURAL only tri[0].depth is used, the triangle is drawn on the background rectangle
+    //in RENDER_ZOOM only tri[0] is used, refilled with glBufferData from 'zoom'
+    //in RENDER_CHAOS the slots take turns holding each frame's points, which are added up in 'chaos'
+    //with --progressive only tri[0] is used, owning its VBO, which 'progressive' fills a bit every frame
+    //with --incremental only tri[0] is used, owning its VBO, which 'incremental' appends new levels to
+    StreamBuffer stream(STREAM_SLOTS);
+    Renderable tri[STREAM_SLOTS];
+    unsigned int meshVBO = 0;
+    int front = 0;
+    GeometryBuild build;
+    ProgressiveBuild progressive;
+    IncrementalGeometry incremental;
+    ZoomGeometry zoom;
+    ChaosAccumulation chaos;
+    if(renderMode == RENDER_INSTANCED){
+        unitTriangleOpenGLObj(meshVBO);
+    }
+    if(renderMode == RENDER_CHAOS){
+        int walkerCount = generatorThreads > 0 ? generatorThreads : std::max(1u, std::thread::hardware_concurrency());
+        chaos.walkers.resize(walkerCount);
+        chaos.pool.reset(new WorkerPool(walkerCount));
+        for(int i = 0; i < walkerCount; i++){
+            seedChaosWalker(chaos.walkers[i], i);
+        }
+    } else if(progressiveMode){
+        startProgressiveBuild(progressive, tri[front], sierpinskiDepth);     //drawn as it arrives, from the first frame on
+    } else if(incrementalMode){
+        startIncrementalBuild(incremental, tri[front], sierpinskiDepth);   //drawn once built, by the render loop
+    } else if(renderMode != RENDER_ZOOM){      //the zoom mode is built in the render loop, since it depends on the view
+        loadGeometryNow(build, stream, tri, front, meshVBO, sierpinskiDepth, &bench.generateMs, &bench.uploadMs);
+    }
 
 
     //VAOs, VBOs, EBOs for the background
     unsigned int bgVAO, bgVBO, bgEBO;
     backgroundOpenGLObj(bgVAO, bgVBO, bgEBO);
 
+    //the other monitors draw the same triangle, from the same buffers, on threads of their own
+    const Shader &wallShader = renderMode == RENDER_PACKED ? packedShader
+                             : renderMode == RENDER_INSTANCED ? instancedShader : myShader;
+    startWallThreads(wall, bgVBO, bgEBO, meshVBO);
+
+    //frame timing, shown by the overlay and written to the log
+    FrameProfiler profiler;
+    if(profileLogPath != NULL){
+        profiler.openLog(profileLogPath);
+    }
+    Renderable overlay;
+    std::vector<vertex_t> overlayVertices;
+    double lastOverlayUpdate = 0.0;
+    FramePacer pacer(frameLimit);
+    //the chaos game and the procedural mode draw no mesh, so there are no levels to sort out
+    bool depthTested = depthTest && renderMode != RENDER_CHAOS && renderMode != RENDER_PROCEDURAL;
+    bench.start = glfwGetTime();
+
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);   //uncomment to draw in wireframe mode
     //---------------RENDER LOOP-------------------
     while (!glfwWindowShouldClose(window))
     {
+        //event driven: sleep until there is something new to show, unless the last frame still had work going on
+        if(presentMode == PRESENT_EVENTS){
+            bool animating = build.running || progressive.running || incremental.running || reload.running
+                             || sierpinskiDepth != tri[front].depth || renderMode == RENDER_CHAOS;
+            if(!animating){
+                waitForRedraw(window, reload, shaders, sizeof(shaders) / sizeof(shaders[0]));
+                if(glfwWindowShouldClose(window)){
+                    break;
+                }
+            }
+            redrawRequested = false;
+        }
+        profiler.beginFrame();
+
+        //benchmark: once enough frames were drawn at a depth, report it and move on to the next
+        if(benchmarkMode){
+            if(bench.frame == benchmarkFrames){
+                glFinish();
+                double fps = bench.frame / (glfwGetTime() - bench.start);
+                printf("%d,%d,%zu,%.3f,%.3f,%d,%.2f\n", bench.depth, visibleDepth(bench.depth),
+                       fractalVertexCount(*fractal, bench.depth), bench.generateMs, bench.uploadMs, bench.frame, fps);
+                if(++bench.depth > benchmarkMaxDepth){
+                    break;
+                }
+                sierpinskiDepth = bench.depth;
+                loadGeometryNow(build, stream, tri, front, meshVBO, bench.depth, &bench.generateMs, &bench.uploadMs);
+                bench.frame = 0;
+                bench.start = glfwGetTime();
+            }
+            bench.frame++;
+        }
+
+        //export: draw the next tile, or finish once every tile was drawn
+        if(exportPath != NULL){
+            if(image.next == image.tilesX * image.tilesY){
+                finishImageExport(image);
+                break;
+            }
+            tile = beginImageTile(image);
+        }
+
         // input
         // -----
         processInput(window);
+        pollShaderReload(reload, shaders, sizeof(shaders) / sizeof(shaders[0]));
+        profiler.mark(PROFILE_INPUT);
+
+        //regenerate the triangle in the background whenever the requested depth changes
+        //the generated mode has nothing to rebuild, it just draws more or fewer vertices
+        //the zoom mode rebuilds what is around the view once the view leaves it
+        // -----
+        if(renderMode == RENDER_GENERATED){
+            if(sierpinskiDepth != tri[front].depth){
+                sierpinskiGeneratedOpenGLObj(tri[front], sierpinskiDepth);
+            }
+        } else if(renderMode == RENDER_PROCEDURAL){
+            tri[front].depth = sierpinskiDepth;
+        } else if(renderMode == RENDER_ZOOM){
+            if(zoomNeedsRebuild(zoom, view)){
+                initSierpinskiView(zoom, view);
+                sierpinskiOpenGLObj(tri[front], zoom.vertices, zoom.deepest);
+            }
+        } else if(renderMode == RENDER_CHAOS){
+            //a new batch of points every frame, written straight into the next stream buffer slot
+            //the slot was retired when its last batch was drawn, so beginWrite waits for that draw
+            front = (front + 1) % STREAM_SLOTS;
+            tri[front].count = 0;
+            float *points = (float *)stream.beginWrite(front, (size_t)chaosPoints * 2 * sizeof(float));
+            if(points != NULL){
+                chaosGameParallel(*chaos.pool, chaos.walkers, points, chaosPoints);
+                if(stream.endWrite(front)){
+                    chaosPointsOpenGLObj(tri[front], stream.buffer(front), chaosPoints);
+                }
+            }
+        } else if(progressiveMode){
+            //a new depth starts over, then every frame uploads part of what the worker has written
+            if(sierpinskiDepth != tri[front].depth){
+                startProgressiveBuild(progressive, tri[front], sierpinskiDepth);
+            }
+            uploadProgressiveBuild(progressive, tri[front], uploadBudget);
+        } else if(incrementalMode){
+            //levels already in the VBO are shown right away, deeper ones are built and appended first
+            finishIncrementalBuild(incremental, tri[front], meshVBO);
+            if(sierpinskiDepth != tri[front].depth){
+                if(sierpinskiDepth <= incremental.builtDepth){
+                    showIncrementalDepth(tri[front], sierpinskiDepth);
+                } else if(!incremental.running){
+                    startIncrementalBuild(incremental, tri[front], sierpinskiDepth);
+                }
+            }
+        } else if(!build.running && sierpinskiDepth != tri[front].depth
+                  && !wallDrawingFrom(wall, (front + 1) % STREAM_SLOTS)){   //else retried once the other monitors moved on
+            if(prepareGeometryBuild(build, stream, (front + 1) % STREAM_SLOTS, sierpinskiDepth)){
+                startGeometryBuild(build);
+            } else{
+                sierpinskiDepth = tri[front].depth;     //keep what we have instead of retrying every frame
+            }
+        }
+        if(finishGeometryBuild(build) && uploadGeometry(tri[build.slot], build, stream, meshVBO)){
+            stream.retire(front);   //the next write to it waits for the draws already issued from it
+            front = build.slot;
+        }
+        publishWallScene(wall, tri[front], front, myShader.programID, wallShader.programID);
+        if(showOverlay && glfwGetTime() - lastOverlayUpdate >= OVERLAY_INTERVAL){
+            overlayOpenGLObj(overlay, overlayVertices, profiler);
+            lastOverlayUpdate = glfwGetTime();
+        }
+        profiler.mark(PROFILE_GEOMETRY);
 
         //fill background
         // -----------------
+        profiler.beginGPU();
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        glClear(depthTested ? GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT);
 
         //use shader programs defined in shader.h
         myShader.use();
-        //render background rectangle
-        glBindVertexArray(bgVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, bgVBO);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        vertexTile.set(tile);
+        //render background rectangle, unless it goes behind the triangle once that is drawn
+        if(!depthTested){
+            glBindVertexArray(bgVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, bgVBO);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        }
 
         //render sierpinski triangle
-        glBindVertexArray(triVAO);
-        int triBufSize = 0;
-        glBindBuffer(GL_ARRAY_BUFFER, triVBO);
-        glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &triBufSize);
-        glDrawArrays(GL_TRIANGLES, 0, triBufSize);
-        glBindVertexArray(0);
+        if(renderMode == RENDER_PACKED){
+            //colors come from the palette, positioned between its two ends by depth
+            packedShader.use();
+            packedMaxDepth.set(tri[front].depth);
+            packedTile.set(tile);
+            packedPalette.set(palette, 2);     //a reloaded program starts with its uniforms at 0
+        } else if(renderMode == RENDER_INSTANCED){
+            //one instance per sub-triangle, colored by its depth in the vertex shader
+            instancedShader.use();
+            instancedMaxDepth.set((float)tri[front].depth);
+            instancedTile.set(tile);
+        } else if(renderMode == RENDER_GENERATED){
+            //every vertex is decoded from gl_VertexID, in the same order initSierpinski uses
+            generatedShader.use();
+            generatedMaxDepth.set(tri[front].depth);
+            generatedTile.set(tile);
+        } else if(renderMode == RENDER_PROCEDURAL){
+            //every pixel of the background rectangle works out its own color, down to pixel sized levels
+            proceduralShader.use();
+            proceduralMaxDepth.set(tri[front].depth);
+            proceduralDrawDepth.set(visibleDepth(tri[front].depth));
+            proceduralTile.set(tile);
+        } else if(renderMode == RENDER_ZOOM){
+            //the geometry is relative to the view it was built for, so only the small difference
+            //to the current view goes to the vertex shader, worked out here in double precision
+            //panning or zooming inside the built area only changes these uniforms
+            const View &built = zoom.built;
+            zoomShader.use();
+            zoomOffset.set({(float)((built.centerX - view.centerX) * built.zoom),
+                            (float)((built.centerY - view.centerY) * built.zoom)});
+            zoomScale.set((float)(view.zoom / built.zoom));
+        }
+        if(renderMode == RENDER_CHAOS){
+            //add this frame's points to the accumulation buffer, one hit per point
+            if(chaosAccumulationOpenGLObj(chaos, framebufferWidth, framebufferHeight) && tri[front].count > 0){
+                glBindFramebuffer(GL_FRAMEBUFFER, chaos.FBO);
+                glViewport(0, 0, chaos.width, chaos.height);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE);
+                chaosShader.use();
+                drawRenderable(tri[front], tri[front].depth);
+                stream.retire(front);
+                chaos.points += tri[front].count;
+                glBindFramebuffer(GL_FRAMEBUFFER, offscreenFBO);
+                glViewport(0, 0, framebufferWidth, framebufferHeight);
+
+                //then show all the hits so far over the background, drawn on the background rectangle
+                //the triangle covers about one pixel per triangle of the level whose triangles are pixel sized
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                chaosDisplayShader.use();
+                chaosExposure.set((float)(pow(3.0, visibleDepth(MAX_SIERPINSKI_DEPTH)) / chaos.points));
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, chaos.texture);
+                glBindVertexArray(bgVAO);
+                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                glBindVertexArray(0);
+                glBindTexture(GL_TEXTURE_2D, 0);
+                glDisable(GL_BLEND);
+            }
+        } else if(renderMode == RENDER_PROCEDURAL){
+            glBindVertexArray(bgVAO);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            glBindVertexArray(0);
+        } else if(depthTested){
+            //deeper levels are nearer, so drawing them first lets the depth test throw away the fragments
+            //of every parent they cover before they are shaded, and the background only fills what is left
+            //(the zoom mode culls its levels to the view, so it can't pick them out and draws in order)
+            glEnable(GL_DEPTH_TEST);
+            if(renderMode == RENDER_ZOOM){
+                drawRenderable(tri[front], tri[front].depth);
+            } else{
+                drawRenderableFrontToBack(tri[front], visibleDepth(tri[front].depth));
+            }
+            myShader.use();
+            glDepthRange(BACKGROUND_DEPTH, BACKGROUND_DEPTH);
+            glBindVertexArray(bgVAO);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            glBindVertexArray(0);
+            glDepthRange(0.0, 1.0);
+            glDisable(GL_DEPTH_TEST);
+        } else{
+            //levels whose triangles are smaller than a pixel are not drawn at all
+            //(the zoom mode already stops at pixel sized triangles for its view)
+            drawRenderable(tri[front], renderMode == RENDER_ZOOM ? tri[front].depth : visibleDepth(tri[front].depth));
+        }
+        profiler.endGPU();
+        if(exportPath != NULL){
+            endImageTile(image);
+        }
+
+        //frame timing overlay, drawn with the background's shader, outside of the GPU timing
+        if(showOverlay && overlay.count > 0){
+            myShader.use();
+            drawRenderable(overlay, overlay.depth);
+        }
+        profiler.mark(PROFILE_DRAW);
  
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
+        pacer.wait();
+        presentWallFrame(wall);
         glfwPollEvents();
+        if(!pollWallWindows(wall)){
+            glfwSetWindowShouldClose(window, 1);
+        }
+        profiler.mark(PROFILE_SWAP);
+        profiler.endFrame();
     }
     //---------------FINISHED RENDER LOOP-------------------
+    if(showOverlay || profileLogPath != NULL){
+        profiler.printStats();
+        scratch_stats_t scratch = generatorScratchStats();
+        printf("generator scratch: %.1f MB reserved in %d arenas, high-water mark %.1f MB, grown %zu times\n",
+               scratch.reserved / 1048576.0, scratch.arenas, scratch.highWater / 1048576.0, scratch.grows);
+    }
 
     //finished rendering, deallocate resources
-    glDeleteVertexArrays(1, &triVAO);
-    glDeleteBuffers(1, &triVBO);
+    stopWall(wall);     //before anything its render threads draw with is deleted
+    if(build.running){
+        build.worker.join();
+    }
+    stopProgressiveBuild(progressive);
+    if(incremental.running){
+        incremental.worker.join();
+    }
+    if(reload.running){
+        reload.worker.join();
+    }
+    for(int i = 0; i < STREAM_SLOTS; i++){
+        glDeleteVertexArrays(1, &tri[i].VAO);
+        if(renderMode == RENDER_INDEXED || renderMode == RENDER_ZOOM || progressiveMode || incrementalMode){
+            glDeleteBuffers(1, &tri[i].VBO);    //streamed VBOs belong to 'stream' instead
+        }
+        glDeleteBuffers(1, &tri[i].EBO);
+    }
+    glDeleteBuffers(1, &meshVBO);
+    glDeleteVertexArrays(1, &overlay.VAO);
+    glDeleteBuffers(1, &overlay.VBO);
     glDeleteVertexArrays(1, &bgVAO);
     glDeleteBuffers(1, &bgVBO);
     glDeleteBuffers(1, &bgEBO);
+    glDeleteFramebuffers(1, &chaos.FBO);
+    glDeleteTextures(1, &chaos.texture);
+    glDeleteFramebuffers(1, &offscreenFBO);
+    glDeleteRenderbuffers(1, &offscreenRBO);
+    glDeleteRenderbuffers(1, &offscreenDepthRBO);
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -92,93 +942,904 @@ int main()
 }
 
 /**
- * Method that gives the initial pts of a sierpinski triangle, then calls the recursive
- * function to add necessary vertices to a vector of floats
- * @param points the vector we wish to add vertex coordinates to
- * post: points contains the vertex information of a Sierpinski Triangle
+ * Checks whether the geometry of RENDER_ZOOM has to be built again for a view
+ * @param geometry the geometry of RENDER_ZOOM
+ * @param view the view about to be drawn
+ * @return true if it was never built, the view is no longer inside the area it was built for,
+ *         or the zoom changed by more than ZOOM_REBUILD_RATIO
 */
-void initSierpinski(std::vector<float> &points){
-    point_t a = {-0.5f, -0.5f,  0.0f};
-    point_t b = { 0.0f,  0.5f,  0.0f};
-    point_t c = { 0.5f, -0.5f,  0.0f};
-    addSierpinskiPts(a, b, c, 0, points);
+bool zoomNeedsRebuild(const ZoomGeometry &geometry, const View &view){
+    if(!geometry.valid){
+        return true;
+    }
+    const View &built = geometry.built;
+    double ratio = view.zoom / built.zoom;
+    if(ratio > ZOOM_REBUILD_RATIO || ratio < 1.0 / ZOOM_REBUILD_RATIO){
+        return true;
+    }
+    //the window shows 1 / zoom around the center in every direction
+    double builtExtent = ZOOM_MARGIN / built.zoom;
+    double viewExtent = 1.0 / view.zoom;
+    return fabs(view.centerX - built.centerX) + viewExtent > builtExtent
+        || fabs(view.centerY - built.centerY) + viewExtent > builtExtent;
 }
 
+/**
+ * Builds the part of the Sierpinski Triangle around a view for RENDER_ZOOM. It walks the triangle
+ * level by level like initSierpinski, but drops every sub-triangle outside of ZOOM_MARGIN times
+ * the view's extent before subdividing it further, and stops at the first level whose triangles
+ * are smaller than a pixel. So the amount of geometry depends on how much of the window the
+ * triangle covers, not on how deep the view is.
+ * Positions are camera relative: the levels whose triangles are larger than the view ("tiles")
+ * are walked in double precision around the real position of the view, and each level is written
+ * out relative to the view center and scaled by the zoom. From the first level smaller than the
+ * view on, triangles are only a few pixels to a few windows in size in those coordinates, so the
+ * rest is subdivided in float with the SIMD kernels without losing any precision.
+ * Levels are colored like an 8 level triangle ending at the deepest level, so zooming in looks
+ * the same at every depth.
+ * @param geometry the geometry to build
+ * @param view the view to build it around
+ * post: - geometry.vertices holds every built triangle, 3 vertices each, level by level, relative
+ *         to 'view' (see ZoomGeometry)
+ *       - geometry.built is 'view', and geometry.deepest the deepest level built
+*/
+void initSierpinskiView(ZoomGeometry &geometry, const View &view){
+    geometry.built = view;
+    geometry.valid = true;
+    geometry.vertices.clear();
+
+    //size of a level 0 triangle in pixels, see visibleDepth
+    double pixels = 0.5 * view.zoom * std::min(framebufferWidth, framebufferHeight);
+    int deepest = 0;
+    while(pixels * 0.5 >= 1.0){
+        pixels *= 0.5;
+        deepest++;
+    }
+    const int colorLevels = std::min(deepest, DEFAULT_SIERPINSKI_DEPTH);
+
+    //the area kept, in triangle coordinates and in view relative coordinates
+    const double extent = ZOOM_MARGIN / view.zoom;
+    const double minX = view.centerX - extent, maxX = view.centerX + extent;
+    const double minY = view.centerY - extent, maxY = view.centerY + extent;
+    const float relExtent = (float)ZOOM_MARGIN;
+
+    std::vector<dtriangle_t> *tiles = &geometry.tiles[0];
+    tiles->assign(1, {-0.5, -0.5,  0.0, 0.5,  0.5, -0.5});
+    triangles_t levels[2];
+    triangles_t *current = NULL;
+    int level = 0;
+    double size = 1.0;      //size of the triangles of 'level' in triangle coordinates
+    while(true){
+        if(current == NULL){
+            //still a tile level: write it relative to the view into the float scratch
+            std::vector<dtriangle_t> &t = *tiles;
+            triangles_t &rel = levels[level % 2];
+            allocTriangles(rel, geometry.scratch[level % 2], t.size());
+            for(size_t i = 0; i < t.size(); i++){
+                rel.ax[i] = (float)((t[i].ax - view.centerX) * view.zoom);
+                rel.ay[i] = (float)((t[i].ay - view.centerY) * view.zoom);
+                rel.bx[i] = (float)((t[i].bx - view.centerX) * view.zoom);
+                rel.by[i] = (float)((t[i].by - view.centerY) * view.zoom);
+                rel.cx[i] = (float)((t[i].cx - view.centerX) * view.zoom);
+                rel.cy[i] = (float)((t[i].cy - view.centerY) * view.zoom);
+            }
+            rel.count = t.size();
+            if(size * view.zoom < 1.0){
+                current = &rel;     //smaller than the view, float is enough from here on
+            }
+            cullTriangles(rel, -relExtent, relExtent, -relExtent, relExtent);
+            if(rel.count == 0){
+                break;
+            }
+            size_t first = geometry.vertices.size();
+            geometry.vertices.resize(first + 3 * rel.count);
+            int colorLevel = std::max(0, level - (deepest - colorLevels));
+            emitSierpinskiLevel(rel, geometry.vertices.data() + first, colorLevel, colorLevels);
+        } else{
+            if(current->count == 0){
+                break;
+            }
+            size_t first = geometry.vertices.size();
+            geometry.vertices.resize(first + 3 * current->count);
+            int colorLevel = std::max(0, level - (deepest - colorLevels));
+            emitSierpinskiLevel(*current, geometry.vertices.data() + first, colorLevel, colorLevels);
+        }
+        geometry.deepest = level;
+        if(level == deepest){
+            break;
+        }
+
+        if(current == NULL){
+            std::vector<dtriangle_t> *next = &geometry.tiles[(level + 1) % 2];
+            subdivideTiles(*tiles, *next, minX, maxX, minY, maxY);
+            tiles = next;
+        } else{
+            triangles_t &next = levels[(level + 1) % 2];
+            allocTriangles(next, geometry.scratch[(level + 1) % 2], 3 * current->count);
+            subdivide(*current, next);
+            cullTriangles(next, -relExtent, relExtent, -relExtent, relExtent);
+            current = &next;
+        }
+        size *= 0.5;
+        level++;
+    }
+}
 
 /**
- * Helper method to calculate midpoint between two coordinates in 3d space
- * @param a the first point
- * @param b the second point
- * @return a point that contains the x, y, z midpoint coordinates between
- *         'a' and 'b'
+ * Size of the geometry the current render mode streams into a StreamBuffer slot
+ * @param depth the depth of the triangle
+ * @return the size in bytes, 0 if the current render mode does not stream its geometry
+ *         (RENDER_INDEXED is only known in size once built, RENDER_GENERATED has no geometry)
 */
-point_t midpoint(point_t a, point_t b){
-    point_t p;
-    p.x = (a.x + b.x) / 2.0;
-    p.y = (a.y + b.y) / 2.0;
-    p.z = (a.z + b.z) / 2.0;
-    return p;
+size_t streamedGeometrySize(int depth){
+    if(renderMode == RENDER_VERTICES){
+        return fractalVertexCount(*fractal, depth) * sizeof(vertex_t);
+    } else if(renderMode == RENDER_PACKED){
+        return fractalVertexCount(*fractal, depth) * sizeof(packed_vertex_t);
+    } else if(renderMode == RENDER_INSTANCED){
+        return sierpinskiVertexCount(depth) / 3 * sizeof(instance_t);
+    }
+    return 0;
 }
 
 /**
- * Helper function that adds all the position and color values of a vertex into a vector of floats
- * @param p a point that contains the x, y, z values that we wish to add to the vector
- * @param depth the current recursive depth of the point for which we wish to draw
- *              we will use this value to determine what the blue color of the vertex should be
- * @param points a reference to a vector to which we add the necessary vertex data (color and position)
- * pre: none
- * post: points contains the needed position and color data
+ * Gets a build ready to generate a triangle, mapping the stream buffer slot it is written into
+ * if the current render mode streams its geometry
+ * @param build the build state to prepare
+ * @param stream the stream buffer the geometry is written into
+ * @param slot the slot of 'stream' to write into
+ * @param depth the depth of the triangle to generate
+ * @return false if the slot could not be mapped
+ * pre: - build is not running
+ *      - slot is not being drawn from
+ * post: build.depth, build.slot and build.target are set, and the build can be generated
 */
-void addPosAndColor(point_t p, int depth, std::vector<float> &points){
-        points.push_back(p.x);
-        points.push_back(p.y);
-        points.push_back(p.z);
-        points.push_back(0.25f);
-        points.push_back(depth * 1.0/MAX_SIERPINSKI_DEPTH);
-        points.push_back(0.75f);
+bool prepareGeometryBuild(GeometryBuild &build, StreamBuffer &stream, int slot, int depth){
+    build.depth = depth;
+    build.slot = slot;
+    build.target = NULL;
+    size_t size = streamedGeometrySize(depth);
+    if(size == 0){
+        return true;
+    }
+    build.target = stream.beginWrite(slot, size);
+    return build.target != NULL;
 }
+
 /**
- * Recursively puts the info needed to draw a sierpinski triangle into
- * a vector
- * @param a a 3d point representing one of the vertices of a triangle
- * @param b another vertex of same triangle
- * @param c another vertex of same triangle
- * @param depth the current recursive depth
- * @param points the vector we want to add the points to
- * 
- * post: points should have the points of a sierpinski triangle, with the smallest recursive triangle 
- *       held at the end of the vector
- */
-void addSierpinskiPts(point_t a, point_t b, point_t c, int depth, std::vector<float>& points){
-    if(depth <= MAX_SIERPINSKI_DEPTH){
-        addPosAndColor(a, depth, points);
-        addPosAndColor(b, depth, points);
-        addPosAndColor(c, depth, points);
+ * Generates a Sierpinski Triangle in the format used by the current render mode, on the calling thread
+ * @param build the build state to generate into, set up by prepareGeometryBuild
+ * post: build.target (or the vectors of 'build', in RENDER_INDEXED) holds a triangle of depth build.depth
+*/
+void generateGeometry(GeometryBuild &build){
+    if(cacheDir != NULL && cachedGeometry(build)){
+        return;
+    }
+    if(renderMode == RENDER_INSTANCED){
+        initSierpinskiInstances((instance_t *)build.target, build.depth);
+    } else if(renderMode == RENDER_PACKED){
+        initFractalParallel((packed_vertex_t *)build.target, *fractal, build.depth, generatorThreads);
+    } else if(renderMode == RENDER_INDEXED){
+        initSierpinskiIndexed(build.vertices, build.indices, build.depth);
+    } else if(renderMode == RENDER_VERTICES){
+        initFractalParallel((vertex_t *)build.target, *fractal, build.depth, generatorThreads);
+    }
+}
+
+/**
+ * Fills a build from the geometry cache in cacheDir (RENDER_VERTICES and RENDER_PACKED). A cached
+ * file is mapped and copied straight into the stream buffer slot. Otherwise the geometry is generated
+ * into a new cache file, then copied into the slot, so the next start can skip the generation.
+ * Files are named <fractal>-<format>-<depth>.geo, and are ignored when they were written by
+ * another version of the program or hold other geometry.
+ * @param build the build state to fill, set up by prepareGeometryBuild
+ * @return false if the render mode isn't cached or the cache file could not be made, in
+ *         which case the geometry still has to be generated
+ * post: if true was returned, build.target holds a triangle of depth build.depth
+*/
+bool cachedGeometry(GeometryBuild &build){
+    if(renderMode != RENDER_VERTICES && renderMode != RENDER_PACKED){
+        return false;
+    }
+    bool packed = renderMode == RENDER_PACKED;
+    uint32_t format = packed ? GEOMETRY_PACKED : GEOMETRY_VERTICES;
+    uint32_t vertexSize = packed ? sizeof(packed_vertex_t) : sizeof(vertex_t);
+    std::string path = std::string(cacheDir) + "/" + fractal->name + (packed ? "-packed-" : "-vertices-")
+                       + std::to_string(build.depth) + ".geo";
 
-        point_t ab = midpoint(a, b);
-        point_t ac = midpoint(a, c);
-        point_t bc = midpoint(b, c);
-        addSierpinskiPts(a, ab, ac, depth + 1, points);
-        addSierpinskiPts(b, ab, bc, depth + 1, points);
-        addSierpinskiPts(c, ac, bc, depth + 1, points);
+    GeometryFile file;
+    if(file.openRead(path.c_str(), *fractal, format, vertexSize, build.depth)){
+        memcpy(build.target, file.vertices(), file.verticesSize());
+        return true;
+    }
+    void *out = file.create(path.c_str(), *fractal, format, vertexSize, build.depth);
+    if(out == NULL){
+        return false;
+    }
+    if(packed){
+        initFractalParallel((packed_vertex_t *)out, *fractal, build.depth, generatorThreads);
+    } else{
+        initFractalParallel((vertex_t *)out, *fractal, build.depth, generatorThreads);
     }
+    memcpy(build.target, out, file.verticesSize());
+    file.commit();
+    return true;
 }
 
+/**
+ * Starts generating a Sierpinski Triangle on a worker thread
+ * @param build the build state to run the generation in, set up by prepareGeometryBuild
+ * pre: build is not running
+ * post: build is running, and build.done will be set once the triangle has been generated
+*/
+void startGeometryBuild(GeometryBuild &build){
+    build.done = false;
+    build.running = true;
+    build.worker = std::thread([&build](){
+        generateGeometry(build);
+        build.done = true;
+    });
+}
+
+/**
+ * Collects the result of a worker started by startGeometryBuild if it has finished,
+ * without ever waiting on the worker
+ * @param build the build state to check
+ * @return true if a finished triangle of depth build.depth is ready for uploadGeometry,
+ *         false if no build is running or the worker is still generating
+ * post: if true is returned, the worker has been joined and build is no longer running
+*/
+bool finishGeometryBuild(GeometryBuild &build){
+    if(!build.running || !build.done){
+        return false;
+    }
+    build.worker.join();
+    build.running = false;
+    return true;
+}
+
+/**
+ * Makes a finished build drawable through a renderable. Streamed geometry is already in its
+ * stream buffer slot, so only the slot is finished and the VAO pointed at it. RENDER_INDEXED
+ * geometry is copied into the renderable's own buffers.
+ * @param tri the renderable to draw the build with, the one belonging to build.slot
+ * @param build the finished build
+ * @param stream the stream buffer the build was written into
+ * @param meshVBO the VBO holding the unit triangle (RENDER_INSTANCED)
+ * @return false if the contents of the slot were lost, in which case the build has to be redone
+ * post: if true was returned, tri draws the triangle of depth build.depth
+*/
+bool uploadGeometry(Renderable &tri, GeometryBuild &build, StreamBuffer &stream, unsigned int meshVBO){
+    if(renderMode == RENDER_INDEXED){
+        sierpinskiIndexedOpenGLObj(tri, build.vertices, build.indices, build.depth);
+        return true;
+    }
+    if(!stream.endWrite(build.slot)){
+        printf("\nSTREAM BUFFER CONTENTS LOST, REGENERATING\n");
+        return false;
+    }
+    sierpinskiStreamedOpenGLObj(tri, stream.buffer(build.slot), meshVBO, build.depth);
+    return true;
+}
+
+/**
+ * Generates and uploads a triangle on the calling thread, for when there is nothing to draw
+ * until it is done (the first frame, and every depth of a benchmark)
+ * @param build the build state to generate in
+ * @param stream the stream buffer the geometry is written into
+ * @param tri the renderables of the stream buffer slots
+ * @param front the slot being drawn from, updated to the slot holding the new triangle
+ * @param meshVBO the VBO holding the unit triangle (RENDER_INSTANCED)
+ * @param depth the depth of the triangle
+ * @param generateMs if not NULL, set to the time spent generating
+ * @param uploadMs if not NULL, set to the time spent uploading, up to the GPU having finished with it
+ * @return false if the triangle could not be generated or uploaded
+ * pre: build is not running, and renderMode is not RENDER_ZOOM or RENDER_CHAOS
+ * post: tri[front] draws a triangle of 'depth', unless false was returned
+*/
+bool loadGeometryNow(GeometryBuild &build, StreamBuffer &stream, Renderable *tri, int &front,
+                     unsigned int meshVBO, int depth, double *generateMs, double *uploadMs){
+    if(generateMs != NULL){
+        *generateMs = 0.0;
+    }
+    if(uploadMs != NULL){
+        *uploadMs = 0.0;
+    }
+    if(renderMode == RENDER_GENERATED){
+        sierpinskiGeneratedOpenGLObj(tri[front], depth);
+        return true;
+    } else if(renderMode == RENDER_PROCEDURAL){
+        tri[front].depth = depth;   //nothing to build, the fragment shader gets the depth
+        return true;
+    }
+    //write into a free slot unless nothing is being drawn yet
+    int slot = tri[front].depth < 0 ? front : (front + 1) % STREAM_SLOTS;
+    double start = glfwGetTime();
+    if(!prepareGeometryBuild(build, stream, slot, depth)){
+        return false;
+    }
+    generateGeometry(build);
+    double generated = glfwGetTime();
+    if(!uploadGeometry(tri[slot], build, stream, meshVBO)){
+        return false;
+    }
+    if(uploadMs != NULL){
+        glFinish();
+        *uploadMs = (glfwGetTime() - generated) * 1000.0;
+    }
+    if(generateMs != NULL){
+        *generateMs = (generated - start) * 1000.0;
+    }
+    if(slot != front){
+        stream.retire(front);
+        front = slot;
+    }
+    return true;
+}
+
+/**
+ * Starts building a triangle progressively, dropping any build still running
+ * @param progressive the progressive build state
+ * @param tri the renderable to draw the triangle with, with a VAO of 0 if it has not been generated yet
+ * @param depth the depth of the triangle
+ * post: - the worker is running, and uploadProgressiveBuild has to be called every frame to upload its chunks
+ *       - tri.VBO has room for the whole triangle, tri.depth is 'depth' and nothing is drawn yet
+*/
+void startProgressiveBuild(ProgressiveBuild &progressive, Renderable &tri, int depth){
+    stopProgressiveBuild(progressive);
+    bool packed = renderMode == RENDER_PACKED;
+    progressive.depth = depth;
+    progressive.vertexCount = fractalVertexCount(*fractal, depth);
+    progressive.vertexSize = packed ? sizeof(packed_vertex_t) : sizeof(vertex_t);
+    size_t size = progressive.vertexCount * progressive.vertexSize;
+    if(progressive.stagingSize < size){
+        //left uninitialized, so only the pages the worker gets to are ever touched
+        progressive.staging.reset(new unsigned char[size]);
+        progressive.stagingSize = size;
+    }
+    progressive.queue.clear();
+    progressive.pending = {0, 0, 0};
+    progressive.pendingUploaded = 0;
+    progressive.uploaded = 0;
+
+    //the storage for the whole triangle is made up front, the chunks are copied into it as they come
+    if(tri.VAO == 0){
+        glGenVertexArrays(1, &tri.VAO);
+        glGenBuffers(1, &tri.VBO);
+        glBindVertexArray(tri.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, tri.VBO);
+        if(packed){
+            packedVertexAttributes();
+        } else{
+            vertexAttributes();
+        }
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, tri.VBO);
+    glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STATIC_DRAW);     //orphans the storage of the last build
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    tri.count = 0;
+    tri.instanceCount = 0;
+    tri.primitive = GL_TRIANGLES;
+    tri.depth = depth;
+
+    progressive.done = false;
+    progressive.cancel = false;
+    progressive.running = true;
+    progressive.worker = std::thread([&progressive, packed, depth](){
+        //hand every chunk over as soon as it is written, waiting for room in the queue if the uploads fall behind
+        auto chunkDone = [&progressive](int level, size_t first, size_t count){
+            while(!progressive.queue.push({level, first, count})){
+                if(progressive.cancel){
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return !progressive.cancel;
+        };
+        if(packed){
+            initFractalProgressive((packed_vertex_t *)progressive.staging.get(), *fractal, depth,
+                                   PROGRESSIVE_CHUNK, chunkDone);
+        } else{
+            initFractalProgressive((vertex_t *)progressive.staging.get(), *fractal, depth,
+                                   PROGRESSIVE_CHUNK, chunkDone);
+        }
+        progressive.done = true;
+    });
+}
+
+/**
+ * Uploads the chunks the worker of a progressive build has finished, as far as the budget allows.
+ * A chunk larger than what is left of the budget is split, and the rest uploaded in the next frames
+ * @param progressive the progressive build state
+ * @param tri the renderable given to startProgressiveBuild
+ * @param budget the most bytes to upload, at least one triangle is uploaded if there is one
+ * post: - tri draws every vertex uploaded so far, which are always the first levels and the start of the next
+ *       - once the whole triangle is uploaded, the worker has been joined
+*/
+void uploadProgressiveBuild(ProgressiveBuild &progressive, Renderable &tri, size_t budget){
+    if(!progressive.running){
+        return;
+    }
+    const size_t vertexSize = progressive.vertexSize;
+    size_t budgetVertices = std::max((size_t)3, budget / vertexSize / 3 * 3);
+    glBindBuffer(GL_ARRAY_BUFFER, tri.VBO);
+    while(budgetVertices > 0){
+        GeometryChunk &chunk = progressive.pending;
+        if(progressive.pendingUploaded == chunk.count){
+            if(!progressive.queue.pop(chunk)){
+                break;      //the worker hasn't written any more yet
+            }
+            progressive.pendingUploaded = 0;
+        }
+        size_t first = chunk.first + progressive.pendingUploaded;
+        size_t count = std::min(chunk.count - progressive.pendingUploaded, budgetVertices);
+        glBufferSubData(GL_ARRAY_BUFFER, first * vertexSize, count * vertexSize,
+                        progressive.staging.get() + first * vertexSize);
+        progressive.pendingUploaded += count;
+        progressive.uploaded = first + count;
+        budgetVertices -= count;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    tri.count = progressive.uploaded;
+    if(progressive.uploaded == progressive.vertexCount && progressive.done){
+        progressive.worker.join();
+        progressive.running = false;
+    }
+}
+
+/**
+ * Stops the worker of a progressive build if it is still running, without waiting for it to finish
+ * the triangle
+ * @param progressive the progressive build state
+ * post: the worker has been joined, and progressive is no longer running
+*/
+void stopProgressiveBuild(ProgressiveBuild &progressive){
+    if(!progressive.running){
+        return;
+    }
+    progressive.cancel = true;
+    progressive.worker.join();
+    progressive.running = false;
+}
+
+/**
+ * Starts building the levels of an incrementally refined triangle that are deeper than the ones it has
+ * @param incremental the incremental refinement state
+ * @param tri the renderable to draw the triangle with, with a VAO of 0 if it has not been generated yet
+ * @param depth the depth to build up to
+ * pre: - incremental is not running and depth > incremental.builtDepth
+ *      - the render mode is RENDER_PACKED or RENDER_INSTANCED
+ * post: - the worker is running, and finishIncrementalBuild has to be called every frame to append its levels
+ *       - tri keeps drawing the levels it drew before
+*/
+void startIncrementalBuild(IncrementalGeometry &incremental, Renderable &tri, int depth){
+    bool instanced = renderMode == RENDER_INSTANCED;
+    if(tri.VAO == 0){
+        glGenVertexArrays(1, &tri.VAO);
+        tri.primitive = GL_TRIANGLES;
+    }
+    size_t size = streamedGeometrySize(depth) - streamedGeometrySize(incremental.builtDepth);
+    if(incremental.staging.size() < size){
+        incremental.staging.resize(size);
+    }
+    incremental.targetDepth = depth;
+    incremental.done = false;
+    incremental.running = true;
+    incremental.worker = std::thread([&incremental, instanced, depth](){
+        if(instanced){
+            extendSierpinskiInstances((instance_t *)incremental.staging.data(), incremental.frontier, depth);
+        } else{
+            extendFractal((packed_vertex_t *)incremental.staging.data(), *fractal, incremental.frontier, depth);
+        }
+        incremental.done = true;
+    });
+}
+
+/**
+ * Appends the levels the worker of an incremental build wrote to the VBO, once it is done.
+ * If the VBO has no room for them it is replaced by one with room for a level more, so the next
+ * step down fits without copying, and the levels it held are copied into the new one on the GPU
+ * @param incremental the incremental refinement state
+ * @param tri the renderable given to startIncrementalBuild
+ * @param meshVBO the VBO holding the unit triangle in RENDER_INSTANCED
+ * @return true if new levels were appended
+ * post: if true was returned, the VBO holds every level up to incremental.builtDepth, the worker has
+ *       been joined and tri still draws the levels it drew before (see showIncrementalDepth)
+*/
+bool finishIncrementalBuild(IncrementalGeometry &incremental, Renderable &tri, unsigned int meshVBO){
+    if(!incremental.running || !incremental.done){
+        return false;
+    }
+    incremental.worker.join();
+    incremental.running = false;
+
+    size_t used = streamedGeometrySize(incremental.builtDepth);
+    size_t needed = streamedGeometrySize(incremental.targetDepth);
+    if(incremental.capacity < needed){
+        unsigned int grown;
+        size_t capacity = streamedGeometrySize(std::min(incremental.targetDepth + 1, maxFractalDepth()));
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, NULL, GL_STATIC_DRAW);
+        if(used > 0){
+            glBindBuffer(GL_COPY_READ_BUFFER, tri.VBO);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &tri.VBO);   //the copy is queued before the delete, so it still reads the old storage
+        tri.VBO = grown;
+        incremental.capacity = capacity;
+        //the attributes are bound to the buffer they were set up with, so point them at the new one
+        glBindVertexArray(tri.VAO);
+        if(renderMode == RENDER_INSTANCED){
+            instanceAttributes(tri.VBO, meshVBO);
+        } else{
+            glBindBuffer(GL_ARRAY_BUFFER, tri.VBO);
+            packedVertexAttributes();
+        }
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, tri.VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, used, needed - used, incremental.staging.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    incremental.builtDepth = incremental.targetDepth;
+    return true;
+}
+
+/**
+ * Draws an incrementally refined triangle at a depth it already has every level of, without building anything
+ * @param tri the renderable given to startIncrementalBuild
+ * @param depth the depth to draw
+ * pre: 0 <= depth <= the builtDepth of the incremental build that filled tri's VBO
+ * post: tri draws levels 0 to 'depth' of the VBO, and tri.depth is 'depth'
+*/
+void showIncrementalDepth(Renderable &tri, int depth){
+    if(renderMode == RENDER_INSTANCED){
+        tri.count = 3;
+        tri.instanceCount = sierpinskiVertexCount(depth) / 3;
+    } else{
+        tri.count = fractalVertexCount(*fractal, depth);
+        tri.instanceCount = 0;
+    }
+    tri.depth = depth;
+}
+
+/**
+ * Rebuilds edited shaders, one at a time. Every SHADER_RELOAD_INTERVAL seconds it looks for a shader
+ * whose files changed and starts building it on a worker thread, and once the worker is done the
+ * new program replaces the old one. The render loop never waits on the build, and the VAOs/VBOs
+ * are left alone. A shader that fails to build keeps its old program (the errors are printed).
+ * @param reload the hot reload state
+ * @param shaders the shaders to watch
+ * @param shaderCount the number of shaders in 'shaders'
+ * pre: called from the thread the main context is current on, between frames
+ * post: a finished program has been swapped into its shader
+*/
+void pollShaderReload(ShaderReload &reload, Shader *const *shaders, int shaderCount){
+    if(reload.running){
+        if(!reload.done){
+            return;
+        }
+        reload.worker.join();
+        reload.running = false;
+        reload.shader->replaceProgram(reload.program);
+        return;
+    }
+
+    double now = glfwGetTime();
+    if(now - reload.lastCheck < SHADER_RELOAD_INTERVAL){
+        return;
+    }
+    reload.lastCheck = now;
+    for(int i = 0; i < shaderCount; i++){
+        if(!shaders[i]->sourcesChanged()){
+            continue;
+        }
+        printf("\nRELOADING SHADER %d\n", i);
+        reload.shader = shaders[i];
+        if(reload.context == NULL){
+            reload.shader->replaceProgram(reload.shader->buildProgram());
+            return;
+        }
+        reload.done = false;
+        reload.running = true;
+        reload.worker = std::thread([&reload](){
+            glfwMakeContextCurrent(reload.context);
+            reload.program = reload.shader->buildProgram();
+            glFinish();     //the program has to be complete before the main context uses it
+            glfwMakeContextCurrent(NULL);
+            reload.done = true;
+        });
+        return;
+    }
+}
+
+/**
+ * Reads the command line arguments given to the program
+ * Accepted arguments:
+ *      --depth N, -d N     recursive depth of the Sierpinski Triangle (0 to MAX_SIERPINSKI_DEPTH)
+ *      --packed            use 8 byte vertices with the color worked out on the GPU (RENDER_PACKED)
+ *      --indexed           store each vertex once per level and draw with an EBO (RENDER_INDEXED)
+ *      --threads N         number of threads generating geometry, by default one per core
+ *      --instanced         draw one instanced unit triangle per sub-triangle (RENDER_INSTANCED)
+ *      --generated         compute every vertex in the vertex shader (RENDER_GENERATED)
+ *      --zoom              pan and zoom without a depth limit, building only what is visible (RENDER_ZOOM)
+ *      --procedural        test every pixel for the triangle in the fragment shader (RENDER_PROCEDURAL)
+ *      --chaos             draw the triangle with the chaos game instead of a mesh (RENDER_CHAOS)
+ *      --points N          points RENDER_CHAOS adds every frame (DEFAULT_CHAOS_POINTS)
+ *      --fractal NAME      build another fractal from the fractals table (RENDER_VERTICES or RENDER_PACKED),
+ *                          such as carpet, vicsek or koch; its depth is limited by maxFractalDepth
+ *      --cache DIR         keep generated geometry in files in DIR and load it from there on
+ *                          the next start (RENDER_VERTICES and RENDER_PACKED), see cachedGeometry
+ *      --progressive       build the triangle on a worker thread and draw it while it arrives,
+ *                          uploading at most --upload-budget per frame (RENDER_VERTICES and RENDER_PACKED)
+ *      --upload-budget MB  megabytes --progressive uploads per frame (DEFAULT_UPLOAD_BUDGET)
+ *      --incremental       change the depth by appending or dropping levels of the one triangle
+ *                          instead of rebuilding it (RENDER_PACKED and RENDER_INSTANCED)
+ *      --present MODE      how frames are presented: vsync (the default), adaptive, uncapped or events,
+ *                          see PresentMode
+ *      --fps N             hold the render loop to N frames per second, see FramePacer
+ *      --wall              go full screen on every monitor, each drawn by its own thread from the
+ *                          one copy of the triangle (RENDER_VERTICES, RENDER_PACKED and RENDER_INSTANCED)
+ *      --msaa N            draw with N samples per pixel, into the window or the offscreen framebuffer
+ *      --no-depth-test     draw every level over its parents, instead of deepest first with the depth
+ *                          test, to compare the two (see drawRenderableFrontToBack)
+ *      --overlay           show the frame timing overlay (toggled with F1)
+ *      --profile-log FILE  log the timing of every frame to FILE, as JSON if it ends in .json, CSV otherwise
+ *      --benchmark         draw --frames frames at every depth of --benchmark-depths into a hidden
+ *                          --resolution sized framebuffer without vsync, and print a CSV row per depth
+ *      --frames N          frames drawn per depth by --benchmark (DEFAULT_BENCHMARK_FRAMES)
+ *      --benchmark-depths A-B  depths swept by --benchmark (0-10)
+ *      --resolution WxH    size of the --benchmark framebuffer (1920x1080)
+ *      --export FILE       draw the triangle into a PPM image instead of a window, in tiles
+ *      --export-size WxH   size of the --export image (16384x16384)
+ *      --tile N            size of the tiles --export draws (DEFAULT_EXPORT_TILE)
+ * @param argc the number of arguments
+ * @param argv the arguments
+ * @return 0 if all arguments were valid, -1 otherwise
+ * post: globals set by the arguments (sierpinskiDepth, renderMode, generatorThreads, showOverlay,
+ *       profileLogPath, benchmarkMode, exportPath, fractal, cacheDir, progressiveMode, incrementalMode, wallMode, presentMode, frameLimit, msaaSamples, depthTest and their settings) are updated
+*/
+int parseArgs(int argc, char **argv){
+    bool depthGiven = false;
+    bool presentGiven = false;
+    for(int i = 1; i < argc; i++){
+        if((strcmp(argv[i], "--depth") == 0 || strcmp(argv[i], "-d") == 0) && i + 1 < argc){
+            sierpinskiDepth = atoi(argv[++i]);
+            depthGiven = true;
+            if(sierpinskiDepth < 0 || sierpinskiDepth > MAX_SIERPINSKI_DEPTH){
+                printf("Depth must be between 0 and %d\n", MAX_SIERPINSKI_DEPTH);
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            generatorThreads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--packed") == 0){
+            renderMode = RENDER_PACKED;
+        } else if(strcmp(argv[i], "--indexed") == 0){
+            renderMode = RENDER_INDEXED;
+        } else if(strcmp(argv[i], "--instanced") == 0){
+            renderMode = RENDER_INSTANCED;
+        } else if(strcmp(argv[i], "--generated") == 0){
+            renderMode = RENDER_GENERATED;
+        } else if(strcmp(argv[i], "--zoom") == 0){
+            renderMode = RENDER_ZOOM;
+        } else if(strcmp(argv[i], "--procedural") == 0){
+            renderMode = RENDER_PROCEDURAL;
+        } else if(strcmp(argv[i], "--chaos") == 0){
+            renderMode = RENDER_CHAOS;
+        } else if(strcmp(argv[i], "--points") == 0 && i + 1 < argc){
+            chaosPoints = atoi(argv[++i]);
+            if(chaosPoints <= 0){
+                printf("Points must be at least 1\n");
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--fractal") == 0 && i + 1 < argc){
+            fractal = findFractal(argv[++i]);
+            if(fractal == NULL){
+                printf("Unknown fractal: %s, pick one of", argv[i]);
+                for(int f = 0; f < FRACTAL_COUNT; f++){
+                    printf(" %s", fractals[f].name);
+                }
+                printf("\n");
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--cache") == 0 && i + 1 < argc){
+            cacheDir = argv[++i];
+        } else if(strcmp(argv[i], "--progressive") == 0){
+            progressiveMode = true;
+        } else if(strcmp(argv[i], "--incremental") == 0){
+            incrementalMode = true;
+        } else if(strcmp(argv[i], "--wall") == 0){
+            wallMode = true;
+        } else if(strcmp(argv[i], "--present") == 0 && i + 1 < argc){
+            const char *mode = argv[++i];
+            if(strcmp(mode, "vsync") == 0){
+                presentMode = PRESENT_VSYNC;
+            } else if(strcmp(mode, "adaptive") == 0){
+                presentMode = PRESENT_ADAPTIVE;
+            } else if(strcmp(mode, "uncapped") == 0){
+                presentMode = PRESENT_UNCAPPED;
+            } else if(strcmp(mode, "events") == 0){
+                presentMode = PRESENT_EVENTS;
+            } else{
+                printf("Present mode must be vsync, adaptive, uncapped or events\n");
+                return -1;
+            }
+            presentGiven = true;
+        } else if(strcmp(argv[i], "--fps") == 0 && i + 1 < argc){
+            frameLimit = atof(argv[++i]);
+            if(frameLimit <= 0.0){
+                printf("Frame rate must be more than 0\n");
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--msaa") == 0 && i + 1 < argc){
+            msaaSamples = atoi(argv[++i]);
+            if(msaaSamples < 0){
+                printf("Samples per pixel can't be negative\n");
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--no-depth-test") == 0){
+            depthTest = false;
+        } else if(strcmp(argv[i], "--upload-budget") == 0 && i + 1 < argc){
+            int megabytes = atoi(argv[++i]);
+            if(megabytes <= 0){
+                printf("Upload budget must be at least 1 MB\n");
+                return -1;
+            }
+            uploadBudget = (size_t)megabytes << 20;
+        } else if(strcmp(argv[i], "--overlay") == 0){
+            showOverlay = true;
+        } else if(strcmp(argv[i], "--profile-log") == 0 && i + 1 < argc){
+            profileLogPath = argv[++i];
+        } else if(strcmp(argv[i], "--benchmark") == 0){
+            benchmarkMode = true;
+        } else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc){
+            benchmarkFrames = atoi(argv[++i]);
+            if(benchmarkFrames <= 0){
+                printf("Frames must be at least 1\n");
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--benchmark-depths") == 0 && i + 1 < argc){
+            //either a single depth or a range such as 4-12
+            int read = sscanf(argv[++i], "%d-%d", &benchmarkMinDepth, &benchmarkMaxDepth);
+            if(read == 1){
+                benchmarkMaxDepth = benchmarkMinDepth;
+            }
+            if(read < 1 || benchmarkMinDepth < 0 || benchmarkMaxDepth > MAX_SIERPINSKI_DEPTH
+               || benchmarkMinDepth > benchmarkMaxDepth){
+                printf("Benchmark depths must be a range within 0-%d\n", MAX_SIERPINSKI_DEPTH);
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--export") == 0 && i + 1 < argc){
+            exportPath = argv[++i];
+        } else if(strcmp(argv[i], "--export-size") == 0 && i + 1 < argc){
+            if(sscanf(argv[++i], "%dx%d", &exportWidth, &exportHeight) != 2 || exportWidth <= 0 || exportHeight <= 0){
+                printf("Export size must be given as WIDTHxHEIGHT\n");
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--tile") == 0 && i + 1 < argc){
+            exportTile = atoi(argv[++i]);
+            if(exportTile <= 0){
+                printf("Tile size must be at least 1\n");
+                return -1;
+            }
+        } else if(strcmp(argv[i], "--resolution") == 0 && i + 1 < argc){
+            if(sscanf(argv[++i], "%dx%d", &benchmarkWidth, &benchmarkHeight) != 2
+               || benchmarkWidth <= 0 || benchmarkHeight <= 0){
+                printf("Resolution must be given as WIDTHxHEIGHT\n");
+                return -1;
+            }
+        } else{
+            printf("Unknown argument: %s\n", argv[i]);
+            printf("Usage: %s [--depth N] [--threads N] [--packed | --indexed | --instanced | --generated | --zoom | --procedural"
+                   " | --chaos [--points N]] [--fractal NAME] [--cache DIR]"
+                   " [--progressive [--upload-budget MB]] [--incremental] [--wall]"
+                   " [--present vsync|adaptive|uncapped|events] [--fps N] [--msaa N] [--no-depth-test]"
+                   " [--overlay] [--profile-log FILE.csv|FILE.json]"
+                   " [--benchmark [--frames N] [--benchmark-depths MIN-MAX] [--resolution WxH]]"
+                   " [--export FILE.ppm [--export-size WxH] [--tile N]]\n", argv[0]);
+            return -1;
+        }
+    }
+    if(fractal != &SIERPINSKI_FRACTAL && renderMode != RENDER_VERTICES && renderMode != RENDER_PACKED){
+        printf("--fractal can only be used with the default render mode or --packed\n");
+        return -1;
+    }
+    if(!depthGiven){
+        sierpinskiDepth = std::min(sierpinskiDepth, maxFractalDepth());
+    }
+    if(sierpinskiDepth > maxFractalDepth() || (benchmarkMode && benchmarkMaxDepth > maxFractalDepth())){
+        printf("Depth must be between 0 and %d for %s\n", maxFractalDepth(), fractal->name);
+        return -1;
+    }
+    if(progressiveMode && (renderMode != RENDER_VERTICES && renderMode != RENDER_PACKED)){
+        printf("--progressive can only be used with the default render mode or --packed\n");
+        return -1;
+    }
+    if(progressiveMode && (benchmarkMode || exportPath != NULL || cacheDir != NULL)){
+        printf("--progressive can't be used with --benchmark, --export or --cache, they need the whole triangle at once\n");
+        return -1;
+    }
+    if(incrementalMode && renderMode != RENDER_PACKED && renderMode != RENDER_INSTANCED){
+        printf("--incremental can only be used with --packed or --instanced, the default render mode colors by total depth\n");
+        return -1;
+    }
+    if(incrementalMode && (progressiveMode || benchmarkMode || exportPath != NULL || cacheDir != NULL)){
+        printf("--incremental can't be used with --progressive, --benchmark, --export or --cache\n");
+        return -1;
+    }
+    if(wallMode && renderMode != RENDER_VERTICES && renderMode != RENDER_PACKED && renderMode != RENDER_INSTANCED){
+        printf("--wall can only be used with the default render mode, --packed or --instanced\n");
+        return -1;
+    }
+    if(wallMode && (progressiveMode || incrementalMode || benchmarkMode || exportPath != NULL)){
+        printf("--wall can't be used with --progressive, --incremental, --benchmark or --export\n");
+        return -1;
+    }
+    if((presentGiven || frameLimit > 0.0) && (benchmarkMode || exportPath != NULL)){
+        printf("--present and --fps can't be used with --benchmark or --export, they never wait on the display\n");
+        return -1;
+    }
+    if(benchmarkMode && (renderMode == RENDER_ZOOM || renderMode == RENDER_CHAOS)){
+        printf("--benchmark can't be used with --zoom or --chaos, they don't draw a triangle of a given depth\n");
+        return -1;
+    }
+    if(exportPath != NULL && (benchmarkMode || renderMode == RENDER_ZOOM || renderMode == RENDER_CHAOS)){
+        printf("--export can't be used with --benchmark, --zoom or --chaos\n");
+        return -1;
+    }
+    return 0;
+}
 
 /**
  * Process all user input by querying GLFW whether relevant
  * keys are pressed or released during the current frame, and
  * react accordingly.
  * For our current implementation, close the window if the user
- * presses the escape key.
+ * presses the escape key, and change the depth of the triangle with +/-.
  * @param window the window for which we want to focus on keypresses
  * pre: window is a valid window
- * post: close the window if the user presses the escape key
+ * post: - close the window if the user presses the escape key
+ *       - sierpinskiDepth goes up/down by one each time +/- is pressed
 */
 void processInput(GLFWwindow *window)
 {
+    static bool plusHeld = false, minusHeld = false, overlayHeld = false;   //so holding a key only counts once
+
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, 1);
+
+    bool plus = glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS
+                || glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS;
+    bool minus = glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS
+                || glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS;
+    if(plus && !plusHeld && sierpinskiDepth < maxFractalDepth())
+        sierpinskiDepth++;
+    if(minus && !minusHeld && sierpinskiDepth > 0)
+        sierpinskiDepth--;
+    plusHeld = plus;
+    minusHeld = minus;
+
+    bool overlayKey = glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS;
+    if(overlayKey && !overlayHeld)
+        showOverlay = !showOverlay;
+    overlayHeld = overlayKey;
+
+    //dragging with the left mouse button pans the view
+    static double lastX = 0.0, lastY = 0.0;
+    double x, y;
+    int width, height;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &width, &height);
+    if(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && width > 0 && height > 0){
+        //a window spans 2 in normalized device coordinates, which is 2 / zoom of the triangle
+        view.centerX -= (x - lastX) * 2.0 / (width * view.zoom);
+        view.centerY += (y - lastY) * 2.0 / (height * view.zoom);
+    }
+    lastX = x;
+    lastY = y;
 }
 
 /**
@@ -192,16 +1853,145 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    framebufferWidth = width;
+    framebufferHeight = height;
+    redrawRequested = true;
+}
+
+/**
+ * glfw: whenever the mouse wheel is scrolled this callback function executes, and zooms the view
+ * in or out around the point under the cursor
+ * @param window the window that was scrolled in
+ * @param xoffset the horizontal scroll offset
+ * @param yoffset the vertical scroll offset, positive to zoom in
+*/
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    double x, y;
+    int width, height;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &width, &height);
+    if(width <= 0 || height <= 0){
+        return;
+    }
+    //the point under the cursor, in normalized device coordinates and in triangle coordinates
+    double ndcX = 2.0 * x / width - 1.0;
+    double ndcY = 1.0 - 2.0 * y / height;
+    double pointX = view.centerX + ndcX / view.zoom;
+    double pointY = view.centerY + ndcY / view.zoom;
+
+    view.zoom = std::min(MAX_ZOOM, std::max(0.25, view.zoom * pow(1.25, yoffset)));
+    //move the center so the same point stays under the cursor
+    view.centerX = pointX - ndcX / view.zoom;
+    view.centerY = pointY - ndcY / view.zoom;
+    redrawRequested = true;
+}
+
+/**
+ * glfw: whenever a key is pressed, repeated or released this callback function executes.
+ * The keys themselves are read by processInput, this only asks for a frame to read them in
+ * @param window the window that has the focus
+ * @param key the key
+ * @param scancode the platform specific code of the key
+ * @param action GLFW_PRESS, GLFW_REPEAT or GLFW_RELEASE
+ * @param mods the modifier keys held down
+*/
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    redrawRequested = true;
+}
+
+/**
+ * glfw: whenever the cursor moves over the window this callback function executes, and asks for
+ * a frame so processInput can pan the view
+ * @param window the window the cursor is over
+ * @param x the x of the cursor, in screen coordinates from the left of the window
+ * @param y the y of the cursor, in screen coordinates from the top of the window
+*/
+void cursor_callback(GLFWwindow* window, double x, double y)
+{
+    //only a drag changes anything
+    if(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS){
+        redrawRequested = true;
+    }
+}
+
+/**
+ * glfw: whenever a mouse button is pressed or released this callback function executes
+ * @param window the window that was clicked in
+ * @param button the mouse button
+ * @param action GLFW_PRESS or GLFW_RELEASE
+ * @param mods the modifier keys held down
+*/
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    redrawRequested = true;
+}
+
+/**
+ * glfw: whenever the contents of the window have to be drawn again (it was uncovered, for
+ * example) this callback function executes
+ * @param window the window to draw again
+*/
+void refresh_callback(GLFWwindow* window)
+{
+    redrawRequested = true;
+}
+
+/**
+ * @return the swap interval of the present mode: 0 for PRESENT_UNCAPPED, -1 for PRESENT_ADAPTIVE
+ *         if the driver supports swap-control-tear, 1 otherwise
+ * pre: the context the interval is meant for is current
+*/
+int presentSwapInterval(){
+    if(presentMode == PRESENT_UNCAPPED){
+        return 0;
+    }
+    if(presentMode == PRESENT_ADAPTIVE && (glfwExtensionSupported("WGL_EXT_swap_control_tear")
+                                           || glfwExtensionSupported("GLX_EXT_swap_control_tear"))){
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * Sleeps until a frame has to be drawn for PRESENT_EVENTS: an input or window callback asked for one,
+ * a shader reload was started, or, while the overlay is shown, its next update is due.
+ * In between it wakes up every SHADER_RELOAD_INTERVAL to look for edited shaders
+ * @param window the main window
+ * @param reload the hot reload state
+ * @param shaders the shaders to watch
+ * @param shaderCount the number of shaders in 'shaders'
+ * post: a frame should be drawn, or the window was asked to close
+*/
+void waitForRedraw(GLFWwindow *window, ShaderReload &reload, Shader *const *shaders, int shaderCount){
+    double start = glfwGetTime();
+    while(!redrawRequested && !glfwWindowShouldClose(window)){
+        double timeout = SHADER_RELOAD_INTERVAL;
+        if(showOverlay){
+            timeout = OVERLAY_INTERVAL - (glfwGetTime() - start);
+            if(timeout <= 0.0){
+                return;
+            }
+        }
+        glfwWaitEventsTimeout(timeout);
+        pollShaderReload(reload, shaders, shaderCount);
+        if(reload.running){
+            return;     //drawn every frame until the new program is swapped in
+        }
+    }
 }
 
 /**
  * Sets up a GLFW Window and loads the OpenGL function pointers
+ * @param visible false to keep the window hidden, for rendering offscreen
+ *                (a visible one has msaaSamples samples per pixel, if the driver has them)
  * @return NULL if we failed to initialize the GLFW window or the function pointers
  *          otherwise, return a GLFWwindow pointer to the initialized window
  * post: - OpenGL function pointers are properly initialized
  *       - return a pointer to the GLFWwindow that has been initialized
 */
-GLFWwindow* glfwOpenGLInit(){
+GLFWwindow* glfwOpenGLInit(bool visible){
 // glfw: initialize to context version 3.3
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -211,6 +2001,9 @@ GLFWwindow* glfwOpenGLInit(){
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+    //a hidden window draws into an offscreen framebuffer, which gets the samples instead
+    glfwWindowHint(GLFW_SAMPLES, visible ? msaaSamples : 0);
 
     // glfw window creation
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
@@ -222,6 +2015,12 @@ GLFWwindow* glfwOpenGLInit(){
     }
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetCursorPosCallback(window, cursor_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetWindowRefreshCallback(window, refresh_callback);
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
 
     // glad: load all OpenGL function pointers
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -230,50 +2029,1001 @@ GLFWwindow* glfwOpenGLInit(){
         glfwTerminate();
         return NULL;
     }
+    if(visible && msaaSamples > 0){
+        int samples = 0;
+        glGetIntegerv(GL_SAMPLES, &samples);
+        if(samples < msaaSamples){
+            printf("Asked for %d samples per pixel, the window has %d\n", msaaSamples, samples);
+        }
+        glEnable(GL_MULTISAMPLE);
+    }
     return window;    
 }
 
 /**
- * Generates a vertex array object for the VAO and a Vertex Buffer object for the VBO. 
- * Then loads the vertices of the sierpinski triangle into the VBO.
- * @param VAO a reference to a VAO id
- * @param VBO a reference to a VBO id
- * post: - VAO is associated with VBO being bound to GL_ARRAY_BUFFER
- *       - the vertices of a sierpinski triangle are located in Vertex Buffer Object who's
- *         ID is given by VBO
- *       - VAOs and VBOs are unbound
- *       
+ * Generates a framebuffer object to render into instead of the window
+ * @param width the width of the framebuffer in pixels
+ * @param height the height of the framebuffer in pixels
+ * @param samples the samples per pixel, 0 for a framebuffer that isn't multisampled,
+ *                at most GL_MAX_SAMPLES are used
+ * @param colorRBO a reference to the id of the renderbuffer holding the colors
+ * @param depthRBO set to the id of the renderbuffer holding the depths, NULL for a framebuffer without one
+ * @return the id of the framebuffer, 0 if it could not be completed (the renderbuffers are deleted then)
+ * post: the framebuffer is bound to GL_FRAMEBUFFER, so everything is drawn into it
 */
-void sierpinskiOpenGLObj(unsigned int &VAO, unsigned int &VBO){
-    //---------FILLING VERTICES WITH POINTS OF SIERPINSKI TRIANGLE-----------
-    std::vector<float> points = {};
-    initSierpinski(points);
-    const size_t len = points.size();
-    float vertices[len];
-    //add all elements into array so we can put it in the VBO
-    for(int i = 0; i < len; i++){
-        vertices[i] = points.at(i);
+unsigned int offscreenFramebuffer(int width, int height, int samples, unsigned int &colorRBO, unsigned int *depthRBO){
+    int maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    samples = std::min(samples, maxSamples);
+    unsigned int FBO;
+    glGenFramebuffers(1, &FBO);
+    glGenRenderbuffers(1, &colorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+    if(depthRBO != NULL){
+        glGenRenderbuffers(1, depthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, *depthRBO);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
     }
-    //---------FILLING VERTICES WITH POINTS OF SIERPINSKI TRIANGLE-----------
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
-    //VAOs and VBOs for sierpinski triangle
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+    if(depthRBO != NULL){
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, *depthRBO);
+    }
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        printf("Failed to create a %dx%d offscreen framebuffer with %d samples\n", width, height, samples);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteRenderbuffers(1, &colorRBO);
+        colorRBO = 0;
+        if(depthRBO != NULL){
+            glDeleteRenderbuffers(1, depthRBO);
+            *depthRBO = 0;
+        }
+        return 0;
+    }
+    return FBO;
+}
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+/**
+ * Opens the PPM an --export run writes to, and sets up the buffers the tiles go through
+ * @param image the export state to set up
+ * @param path the file to write
+ * @param width the width of the image in pixels
+ * @param height the height of the image in pixels
+ * @param tileSize the size of the tiles the image is drawn in, in pixels
+ * @return false if the file could not be opened
+ * post: the header of the PPM is written, and image is ready to draw its first tile
+*/
+bool beginImageExport(ImageExport &image, const char *path, int width, int height, int tileSize){
+    image.file = fopen(path, "wb");
+    if(image.file == NULL){
+        printf("Failed to open %s for writing\n", path);
+        return false;
+    }
+    fprintf(image.file, "P6\n%d %d\n255\n", width, height);
+    image.width = width;
+    image.height = height;
+    image.tileSize = tileSize;
+    image.tilesX = (width + tileSize - 1) / tileSize;
+    image.tilesY = (height + tileSize - 1) / tileSize;
+    image.next = 0;
+    image.bands[0].resize((size_t)width * tileSize * 3);
+    image.bands[1].resize((size_t)width * tileSize * 3);
+
+    //tightly packed RGB rows, so a tile of any width can be copied row by row
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGenBuffers(2, image.pbo);
+    for(int i = 0; i < 2; i++){
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, image.pbo[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)tileSize * tileSize * 3, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    printf("Exporting a %dx%d image to %s in %d tiles\n", width, height, path, image.tilesX * image.tilesY);
+    return true;
+}
+
+/**
+ * Finds the part of the image a tile covers
+ * @param image the export state
+ * @param tile the tile, counting row by row from the top left
+ * @param x set to the left edge of the tile in pixels
+ * @param y set to the top edge of the tile in pixels, counting down from the top of the image
+ * @param w set to the width of the tile in pixels
+ * @param h set to the height of the tile in pixels
+*/
+void imageTileRect(const ImageExport &image, int tile, int &x, int &y, int &w, int &h){
+    x = (tile % image.tilesX) * image.tileSize;
+    y = (tile / image.tilesX) * image.tileSize;
+    w = std::min(image.tileSize, image.width - x);
+    h = std::min(image.tileSize, image.height - y);
+}
+
+/**
+ * Gets ready to draw the next tile of an export
+ * @param image the export state
+ * @return the scale (xy) and offset (zw) the vertex shaders apply to clip space positions so the
+ *         tile fills the framebuffer, see the 'tile' uniform
+ * post: the viewport covers the tile's part of the offscreen framebuffer
+*/
+vec4_t beginImageTile(const ImageExport &image){
+    int x, y, w, h;
+    imageTileRect(image, image.next, x, y, w, h);
+    int glY = image.height - y - h;     //GL counts rows up from the bottom of the image
+    glViewport(0, 0, w, h);
+    //maps [-1, 1] over the whole image onto [-1, 1] over the tile
+    vec4_t tile;
+    tile.x = (float)image.width / w;
+    tile.y = (float)image.height / h;
+    tile.z = (float)(image.width - 2 * x) / w - 1.0f;
+    tile.w = (float)(image.height - 2 * glY) / h - 1.0f;
+    return tile;
+}
+
+/**
+ * Copies a tile that was read back into its PBO into the band of rows it belongs to, and hands
+ * the band to the writer once it is the tile at the end of the band
+ * @param image the export state
+ * @param tile the tile to collect
+ * pre: glReadPixels was issued for 'tile' into image.pbo[tile % 2]
+*/
+void collectImageTile(ImageExport &image, int tile){
+    int x, y, w, h;
+    imageTileRect(image, tile, x, y, w, h);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, image.pbo[tile % 2]);
+    const unsigned char *pixels = (const unsigned char *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                                          (size_t)w * h * 3, GL_MAP_READ_BIT);
+    if(pixels != NULL){
+        //the PBO holds the rows bottom up, the PPM top down
+        unsigned char *band = image.bands[0].data();
+        for(int row = 0; row < h; row++){
+            memcpy(band + ((size_t)(h - 1 - row) * image.width + x) * 3, pixels + (size_t)row * w * 3, (size_t)w * 3);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else{
+        printf("Failed to map tile %d of the export\n", tile);
+        image.failed = true;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if(tile % image.tilesX == image.tilesX - 1){
+        writeImageBand(image, h);
+    }
+}
+
+/**
+ * Hands the band that was just filled to a worker thread that writes it to the file
+ * @param image the export state
+ * @param rows the number of rows of the band that belong to the image
+ * post: bands[0] is free to fill with the next band, bands[1] is being written
+*/
+void writeImageBand(ImageExport &image, int rows){
+    if(image.running){
+        image.writer.join();
+    }
+    std::swap(image.bands[0], image.bands[1]);
+    const unsigned char *band = image.bands[1].data();
+    size_t size = (size_t)image.width * rows * 3;
+    image.writer = std::thread([&image, band, size](){
+        if(fwrite(band, 1, size, image.file) != size){
+            image.failed = true;
+        }
+    });
+    image.running = true;
+}
+
+/**
+ * Reads the tile that was just drawn back into a PBO without waiting for it, then collects the
+ * tile before it, which had a whole tile's worth of drawing to finish its readback
+ * @param image the export state
+ * pre: the tile image.next was drawn into image.tileFBO, which is bound
+ * post: - image.next is the next tile to draw
+ *       - image.tileFBO is still bound
+*/
+void endImageTile(ImageExport &image){
+    int x, y, w, h;
+    imageTileRect(image, image.next, x, y, w, h);
+    if(image.resolveFBO != 0){
+        //multisampled pixels can't be read back, so they are averaged into a single sampled framebuffer first
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, image.resolveFBO);
+        glBlitFramebuffer(0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, image.resolveFBO);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, image.pbo[image.next % 2]);
+    glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, (void *)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if(image.resolveFBO != 0){
+        glBindFramebuffer(GL_FRAMEBUFFER, image.tileFBO);
+    }
+    if(image.next > 0){
+        collectImageTile(image, image.next - 1);
+    }
+    image.next++;
+}
+
+/**
+ * Collects the last tile of an export, waits for the writer and closes the file
+ * @param image the export state
+ * @return false if any part of the image could not be read back or written
+ * pre: every tile was drawn
+ * post: the file is closed and the PBOs and the resolve framebuffer deleted
+*/
+bool finishImageExport(ImageExport &image){
+    if(image.next > 0){
+        collectImageTile(image, image.next - 1);
+    }
+    if(image.running){
+        image.writer.join();
+        image.running = false;
+    }
+    bool written = fclose(image.file) == 0 && !image.failed;
+    image.file = NULL;
+    glDeleteBuffers(2, image.pbo);
+    glDeleteFramebuffers(1, &image.resolveFBO);
+    glDeleteRenderbuffers(1, &image.resolveRBO);
+    if(written){
+        printf("Exported %d tiles\n", image.next);
+    } else{
+        printf("Failed to write the exported image\n");
+    }
+    return written;
+}
+
+/**
+ * Creates a hidden window whose context shares objects (programs, buffers, ...) with the one
+ * of 'window', so other threads can create objects for it
+ * @param window the window created by glfwOpenGLInit
+ * @return the hidden window, or NULL if the driver could not create one
+ * post: the context of 'window' is still current, and new windows are visible again
+*/
+GLFWwindow* glfwSharedContextInit(GLFWwindow *window){
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* shared = glfwCreateWindow(1, 1, "", NULL, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if(shared == NULL){
+        printf("Failed to create a shared context, shaders will be reloaded on the main thread\n");
+    }
+    glfwMakeContextCurrent(window);
+    return shared;
+}
+
+/**
+ * Spreads the main window and new windows over every monitor for --wall. The main window goes full
+ * screen on the primary monitor, and every other monitor gets a full screen window of its own whose
+ * context shares objects (buffers, programs, fences) with the main one, so nothing has to be built twice
+ * @param window the window created by glfwOpenGLInit
+ * @param wall the wall state to add the windows to
+ * @return the number of windows made besides the main one
+ * post: the context of 'window' is still current, and the windows don't minimize when they lose focus
+*/
+int glfwWallInit(GLFWwindow *window, Wall &wall){
+    int monitorCount = 0;
+    GLFWmonitor **monitors = glfwGetMonitors(&monitorCount);
+    if(monitorCount == 0){
+        printf("No monitors found, --wall only shows the main window\n");
+        return 0;
+    }
+    //clicking on one monitor must not minimize the others
+    glfwSetWindowAttrib(window, GLFW_AUTO_ICONIFY, GLFW_FALSE);
+    glfwWindowHint(GLFW_AUTO_ICONIFY, GLFW_FALSE);
+    const GLFWvidmode *mode = glfwGetVideoMode(monitors[0]);
+    glfwSetWindowMonitor(window, monitors[0], 0, 0, mode->width, mode->height, mode->refreshRate);
+    for(int i = 1; i < monitorCount; i++){
+        mode = glfwGetVideoMode(monitors[i]);
+        glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
+        GLFWwindow *shared = glfwCreateWindow(mode->width, mode->height, "LearnOpenGL", monitors[i], window);
+        if(shared == NULL){
+            printf("Failed to create a window on monitor %d (%s)\n", i, glfwGetMonitorName(monitors[i]));
+            continue;
+        }
+        //so PRESENT_EVENTS wakes up for them too, see pollWallWindows
+        glfwSetKeyCallback(shared, key_callback);
+        glfwSetWindowRefreshCallback(shared, refresh_callback);
+        glfwSetWindowCloseCallback(shared, refresh_callback);
+        wall.windows.emplace_back(new WallWindow());
+        WallWindow &target = *wall.windows.back();
+        target.window = shared;
+        int width, height;
+        glfwGetFramebufferSize(shared, &width, &height);
+        target.width = width;
+        target.height = height;
+    }
+    glfwDefaultWindowHints();   //back to the hints of glfwOpenGLInit for any later window
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    glfwMakeContextCurrent(window);
+    return (int)wall.windows.size();
+}
+
+/**
+ * Starts a render thread for every window of a wall, see wallRenderLoop
+ * @param wall the wall state
+ * @param bgVBO the buffer holding the corners of the background rectangle, see backgroundOpenGLObj
+ * @param bgEBO the buffer holding its draw order
+ * @param meshVBO the VBO holding the unit triangle in RENDER_INSTANCED
+ * pre: the scene has been published or is about to be, the render threads draw nothing until then
+*/
+void startWallThreads(Wall &wall, unsigned int bgVBO, unsigned int bgEBO, unsigned int meshVBO){
+    for(std::unique_ptr<WallWindow> &target : wall.windows){
+        WallWindow *w = target.get();
+        w->thread = std::thread([&wall, w, bgVBO, bgEBO, meshVBO](){
+            wallRenderLoop(wall, *w, bgVBO, bgEBO, meshVBO);
+        });
+    }
+}
+
+/**
+ * Draws the published scene into a window of the wall every refresh, or every frame of the main
+ * loop if wallFollowsMainLoop, until the wall is stopped.
+ * When the triangle moves to another buffer, the thread waits on the GPU for the main thread to have
+ * filled it, and only gives up the slot it drew from before once its own draws from it are done
+ * @param wall the wall state
+ * @param target the window to draw into
+ * @param bgVBO the buffer holding the corners of the background rectangle
+ * @param bgEBO the buffer holding its draw order
+ * @param meshVBO the VBO holding the unit triangle in RENDER_INSTANCED
+ * pre: called on a thread of its own, the context of target.window is not current anywhere
+ * post: the objects of the window's context are deleted, and it is no longer current
+*/
+void wallRenderLoop(Wall &wall, WallWindow &target, unsigned int bgVBO, unsigned int bgEBO, unsigned int meshVBO){
+    glfwMakeContextCurrent(target.window);
+    glfwSwapInterval(presentSwapInterval());    //each monitor keeps to its own refresh rate, unless wallFollowsMainLoop
+    //VAOs are not shared between contexts, so this one needs its own
+    unsigned int bgVAO;
+    glGenVertexArrays(1, &bgVAO);
+    glBindVertexArray(bgVAO);
+    backgroundAttributes(bgVBO, bgEBO);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    Renderable tri;
+    WallScene scene;
+    unsigned long version = 0;
+    int slot = -1;
+    bool followMain = wallFollowsMainLoop();
+    unsigned long frame = 0;
+    while(!wall.stop){
+        {
+            std::unique_lock<std::mutex> lock(wall.mutex);
+            if(followMain){
+                //sleeps for as long as the main loop does, whether on its FramePacer or waiting for events
+                wall.framePresented.wait(lock, [&wall, frame](){ return wall.stop || wall.frame != frame; });
+                if(wall.stop){
+                    break;
+                }
+                frame = wall.frame;
+            }
+            scene = wall.scene;
+            if(scene.version != version){
+                //claimed while the main thread can't move on, since it only writes to the slot it isn't drawing
+                wall.readers[scene.slot]++;
+                glWaitSync(scene.ready, 0, GL_TIMEOUT_IGNORED);
+            }
+        }
+        if(scene.version != version){
+            if(slot >= 0){
+                //the main thread may write to the old slot once the draws already issued from it are done
+                GLsync drawn = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                while(glClientWaitSync(drawn, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED){
+                }
+                glDeleteSync(drawn);
+                wall.readers[slot]--;
+            }
+            sierpinskiStreamedOpenGLObj(tri, scene.buffer, meshVBO, scene.depth);
+            version = scene.version;
+            slot = scene.slot;
+        }
+
+        int width = target.width, height = target.height;
+        glViewport(0, 0, width, height);
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(depthTest ? GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT);
+        if(scene.version != 0 && depthTest){
+            //in the same order as the main window, see the render loop
+            glEnable(GL_DEPTH_TEST);
+            glUseProgram(scene.triangleProgram);
+            drawRenderableFrontToBack(tri, visibleDepth(tri.depth, width, height));
+            glUseProgram(scene.backgroundProgram);
+            glDepthRange(BACKGROUND_DEPTH, BACKGROUND_DEPTH);
+            glBindVertexArray(bgVAO);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            glBindVertexArray(0);
+            glDepthRange(0.0, 1.0);
+            glDisable(GL_DEPTH_TEST);
+        } else if(scene.version != 0){
+            glUseProgram(scene.backgroundProgram);
+            glBindVertexArray(bgVAO);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            glUseProgram(scene.triangleProgram);
+            drawRenderable(tri, visibleDepth(tri.depth, width, height));
+        }
+        glfwSwapBuffers(target.window);
+    }
+    if(slot >= 0){
+        glFinish();
+        wall.readers[slot]--;
+    }
+    glDeleteVertexArrays(1, &bgVAO);
+    glDeleteVertexArrays(1, &tri.VAO);
+    glfwMakeContextCurrent(NULL);
+}
+
+/**
+ * Hands the triangle the main thread draws to the render threads of the wall, called every frame
+ * @param wall the wall state
+ * @param tri the renderable the main thread draws the triangle with
+ * @param slot the stream buffer slot tri draws from
+ * @param backgroundProgram the program the background is drawn with
+ * @param triangleProgram the program the triangle is drawn with
+ * post: if the triangle changed, the render threads start drawing it once the GPU has its contents
+*/
+void publishWallScene(Wall &wall, const Renderable &tri, int slot, unsigned int backgroundProgram,
+                      unsigned int triangleProgram){
+    if(wall.windows.empty() || tri.VBO == 0){
+        return;
+    }
+    std::lock_guard<std::mutex> lock(wall.mutex);
+    WallScene &scene = wall.scene;
+    scene.backgroundProgram = backgroundProgram;
+    scene.triangleProgram = triangleProgram;
+    if(scene.buffer == tri.VBO && scene.slot == slot && scene.depth == tri.depth){
+        return;
+    }
+    if(scene.ready != 0){
+        glDeleteSync(scene.ready);  //the render threads only wait on it while holding the lock
+    }
+    scene.ready = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();      //so the other contexts never wait on a fence that was not sent to the GPU
+    scene.buffer = tri.VBO;
+    scene.slot = slot;
+    scene.depth = tri.depth;
+    scene.version++;
+}
+
+/**
+ * Lets the render threads of the wall that follow the main loop draw their next frame, called
+ * every time the main thread presented one
+ * @param wall the wall state
+*/
+void presentWallFrame(Wall &wall){
+    if(wall.windows.empty()){
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wall.mutex);
+        wall.frame++;
+    }
+    wall.framePresented.notify_all();
+}
+
+/**
+ * @return true if the render threads of the wall draw a frame per frame of the main loop instead of
+ *         one per refresh of their monitor: with --fps they keep to its FramePacer, with PRESENT_EVENTS
+ *         they only draw when something changed, and with PRESENT_UNCAPPED they go no faster than it
+*/
+bool wallFollowsMainLoop(){
+    return presentMode == PRESENT_EVENTS || presentMode == PRESENT_UNCAPPED || frameLimit > 0.0;
+}
+
+/**
+ * @param wall the wall state
+ * @param slot a stream buffer slot
+ * @return true if a render thread of the wall may still be drawing from 'slot'
+*/
+bool wallDrawingFrom(const Wall &wall, int slot){
+    return wall.readers[slot] > 0;
+}
+
+/**
+ * Keeps track of the windows of the wall, called by the main thread after every glfwPollEvents
+ * @param wall the wall state
+ * @return false if one of the windows was asked to close, or escape was pressed in it
+ * post: the render threads know the size of their window's framebuffer
+*/
+bool pollWallWindows(Wall &wall){
+    bool open = true;
+    for(std::unique_ptr<WallWindow> &target : wall.windows){
+        int width, height;
+        glfwGetFramebufferSize(target->window, &width, &height);
+        if(width != target->width || height != target->height){
+            redrawRequested = true;     //for PRESENT_EVENTS, the wall only draws when the main window does
+        }
+        target->width = width;
+        target->height = height;
+        if(glfwWindowShouldClose(target->window) || glfwGetKey(target->window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+            open = false;
+        }
+    }
+    return open;
+}
+
+/**
+ * Stops the render threads of the wall and closes its windows
+ * @param wall the wall state
+ * post: every window but the main one is destroyed
+*/
+void stopWall(Wall &wall){
+    {
+        std::lock_guard<std::mutex> lock(wall.mutex);     //so no render thread misses it between checking and waiting
+        wall.stop = true;
+    }
+    wall.framePresented.notify_all();
+    for(std::unique_ptr<WallWindow> &target : wall.windows){
+        if(target->thread.joinable()){
+            target->thread.join();
+        }
+        glfwDestroyWindow(target->window);
+    }
+    wall.windows.clear();
+    if(wall.scene.ready != 0){
+        glDeleteSync(wall.scene.ready);
+        wall.scene.ready = 0;
+    }
+}
+
+/**
+ * Finds the deepest level of a Sierpinski Triangle whose triangles still cover at least a pixel.
+ * The outer triangle spans half of the framebuffer (from -0.5 to 0.5 in both directions), and
+ * every level shrinks its triangles by the ratio of the fractal (half for the Sierpinski Triangle).
+ * @param depth the depth of the triangle
+ * @return the deepest level worth drawing at the current framebuffer size, at most 'depth'
+*/
+int visibleDepth(int depth){
+    return visibleDepth(depth, framebufferWidth, framebufferHeight);
+}
+
+/**
+ * Same as visibleDepth, for a framebuffer other than the main window's
+ * @param depth the depth of the triangle
+ * @param width the width of the framebuffer in pixels
+ * @param height the height of the framebuffer in pixels
+ * @return the deepest level worth drawing in that framebuffer, at most 'depth'
+*/
+int visibleDepth(int depth, int width, int height){
+    float pixels = 0.5f * std::min(width, height);     //size of a level 0 triangle
+    int visible = 0;
+    while(visible < depth && pixels * fractal->ratio >= 1.0f){
+        pixels *= fractal->ratio;
+        visible++;
+    }
+    return visible;
+}
+
+/**
+ * @return the deepest level of the current fractal we allow, as many levels as fit in the
+ *         vertices of a Sierpinski Triangle of depth MAX_SIERPINSKI_DEPTH
+*/
+int maxFractalDepth(){
+    return fractalMaxDepth(*fractal, sierpinskiVertexCount(MAX_SIERPINSKI_DEPTH));
+}
+
+/**
+ * Draws the first levels of a Sierpinski Triangle renderable, using only the values cached in it.
+ * Every layout stores the triangle depth-major, with level L starting at sierpinskiLevelOffset(L)
+ * (or at sierpinskiLevelOffset(L) / 3 for the instances), so levels 0 to 'depth' are a prefix of it
+ * @param obj the renderable to draw
+ * @param depth the deepest level to draw, obj.depth (or more) draws all of it
+ * pre: the shader program obj should be drawn with is in use
+ * post: obj has been drawn, and no VAO is bound
+*/
+void drawRenderable(const Renderable &obj, int depth){
+    int count = obj.count;
+    int instanceCount = obj.instanceCount;
+    if(depth < obj.depth){
+        if(instanceCount > 0){
+            instanceCount = sierpinskiVertexCount(depth) / 3;
+        } else{
+            //a progressive build may not have uploaded all of the levels yet
+            count = std::min((size_t)count, fractalVertexCount(*fractal, depth));
+        }
+    }
+    glBindVertexArray(obj.VAO);
+    if(obj.EBO != 0){
+        glDrawElements(obj.primitive, count, GL_UNSIGNED_INT, 0);
+    } else if(instanceCount > 0){
+        glDrawArraysInstanced(obj.primitive, 0, count, instanceCount);
+    } else{
+        glDrawArrays(obj.primitive, 0, count);
+    }
+    glBindVertexArray(0);
+}
+
+/**
+ * Draws the first levels of a Sierpinski Triangle renderable like drawRenderable, but one level
+ * at a time from the deepest one up. Every level is LEVEL_Z_STEP nearer than its parent, so with
+ * the depth test on the pixels a level covers are already taken when its parents are drawn, and
+ * their fragments are thrown away by the early depth test instead of being shaded over again
+ * @param obj the renderable to draw
+ * @param depth the deepest level to draw, obj.depth (or more) draws all of it
+ * pre: - the shader program obj should be drawn with is in use
+ *      - the depth test is on, with the depth buffer cleared
+ * post: obj has been drawn, and no VAO is bound
+*/
+void drawRenderableFrontToBack(const Renderable &obj, int depth){
+    depth = std::min(depth, obj.depth);
+    glBindVertexArray(obj.VAO);
+    for(int level = depth; level >= 0; level--){
+        if(obj.instanceCount > 0){
+            int first = sierpinskiLevelOffset(level) / 3;
+            int count = std::min((size_t)obj.instanceCount, sierpinskiLevelOffset(level + 1) / 3) - first;
+            if(count <= 0){
+                continue;
+            }
+            if(GLAD_GL_VERSION_4_2){
+                glDrawArraysInstancedBaseInstance(obj.primitive, 0, obj.count, count, first);
+            } else{
+                //without base instances the instance attribute itself has to start at the level
+                glBindBuffer(GL_ARRAY_BUFFER, obj.VBO);
+                glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(instance_t), (void*)(first * sizeof(instance_t)));
+                glDrawArraysInstanced(obj.primitive, 0, obj.count, count);
+            }
+        } else{
+            //a progressive build may not have uploaded all of the levels yet
+            int first = fractalLevelOffset(*fractal, level);
+            int count = std::min((size_t)obj.count, fractalLevelOffset(*fractal, level + 1)) - first;
+            if(count <= 0){
+                continue;
+            }
+            if(obj.EBO != 0){
+                glDrawElements(obj.primitive, count, GL_UNSIGNED_INT, (void*)(first * sizeof(unsigned int)));
+            } else{
+                glDrawArrays(obj.primitive, first, count);
+            }
+        }
+    }
+    if(obj.instanceCount > 0 && !GLAD_GL_VERSION_4_2){
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(instance_t), (void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glBindVertexArray(0);
+}
+
+/**
+ * Loads data into the VBO of a renderable. The first time it is called for a renderable it
+ * generates its VAO/VBO, afterwards the existing VBO is orphaned and refilled so no new
+ * objects are created.
+ * @param obj the renderable to fill, with a VAO of 0 if it has not been generated yet
+ * @param data the data to load into obj.VBO
+ * @param size the size of 'data' in bytes
+ * @return true if the VAO/VBO were just generated, in which case the caller still has to
+ *         set up the vertex attributes
+ * post: - obj.VBO holds 'data'
+ *       - if true was returned, obj.VAO and obj.VBO are still bound, otherwise nothing is bound
+*/
+bool fillVertexBuffer(Renderable &obj, const void *data, size_t size){
+    if(obj.VAO == 0){
+        glGenVertexArrays(1, &obj.VAO);
+        glGenBuffers(1, &obj.VBO);
+
+        glBindVertexArray(obj.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, obj.VBO);
+        glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+        return true;
+    }
+    //orphan the old storage so we never wait on frames still drawing from it
+    glBindBuffer(GL_ARRAY_BUFFER, obj.VBO);
+    glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return false;
+}
+
+/**
+ * Sets up the vertex attributes of vertex_t vertices
+ * pre: the VAO to set up is bound, and the buffer holding the vertices is bound to GL_ARRAY_BUFFER
+ * post: attribute 0 (position) and 1 (color) read from the bound buffer
+*/
+void vertexAttributes(){
     //assigning first attribute (position)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (void*)offsetof(vertex_t, x));
     glEnableVertexAttribArray(0);
     //assign second attribute (color);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (void *)offsetof(vertex_t, r));
     glEnableVertexAttribArray(1);
+}
 
-    glBindVertexArray(0);       //unbind VAO
-    glBindBuffer(GL_ARRAY_BUFFER, 0);   //safely unbind VBO without dissasociating it from VAO
+/**
+ * Sets up the vertex attributes of packed_vertex_t vertices
+ * pre: the VAO to set up is bound, and the buffer holding the vertices is bound to GL_ARRAY_BUFFER
+ * post: attribute 0 reads normalized 16 bit positions and attribute 1 an integer depth
+ *       from the bound buffer
+*/
+void packedVertexAttributes(){
+    //assigning first attribute (position), mapped from [-32767, 32767] to [-1, 1]
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_TRUE, sizeof(packed_vertex_t),
+                          (void*)offsetof(packed_vertex_t, x));
+    glEnableVertexAttribArray(0);
+    //assign second attribute (depth), kept as an integer
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_BYTE, sizeof(packed_vertex_t),
+                           (void *)offsetof(packed_vertex_t, depth));
+    glEnableVertexAttribArray(1);
 }
 
+/**
+ * Sets up the vertex attributes of RENDER_INSTANCED
+ * @param instanceVBO the buffer holding the instance_t instances
+ * @param meshVBO the VBO holding the unit triangle, see unitTriangleOpenGLObj
+ * pre: the VAO to set up is bound
+ * post: - attribute 0 reads the unit triangle positions from meshVBO, and attribute 1 one
+ *         instance_t per instance from instanceVBO
+ *       - meshVBO is bound to GL_ARRAY_BUFFER
+*/
+void instanceAttributes(unsigned int instanceVBO, unsigned int meshVBO){
+    //assign second attribute (offset, scale and depth), advanced once per instance
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(instance_t), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    //assigning first attribute (unit triangle position)
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+}
+
+/**
+ * Loads the vertices of a sierpinski triangle into the VBO of a renderable, see fillVertexBuffer
+ * @param tri the renderable to load the triangle into, with a VAO of 0 if it has not been generated yet
+ * @param vertices the vertices of the sierpinski triangle, as filled by initSierpinski
+ * @param depth the depth the vertices were generated with
+ * post: - tri.VAO is associated with tri.VBO being bound to GL_ARRAY_BUFFER
+ *       - the vertices of a sierpinski triangle are located in Vertex Buffer Object who's
+ *         ID is given by tri.VBO, and tri.count/tri.depth describe them
+ *       - VAOs and VBOs are unbound
+ *       
+*/
+void sierpinskiOpenGLObj(Renderable &tri, const std::vector<vertex_t> &vertices, int depth){
+    tri.count = vertices.size();
+    tri.instanceCount = 0;
+    tri.primitive = GL_TRIANGLES;
+    tri.depth = depth;
+    if(fillVertexBuffer(tri, vertices.data(), vertices.size() * sizeof(vertex_t))){
+        vertexAttributes();
+        glBindVertexArray(0);       //unbind VAO
+        glBindBuffer(GL_ARRAY_BUFFER, 0);   //safely unbind VBO without dissasociating it from VAO
+    }
+}
+
+/**
+ * Loads indices into the EBO of a renderable. Like fillVertexBuffer, the EBO is generated the
+ * first time and orphaned and refilled afterwards.
+ * @param obj the renderable to fill, whose VAO has already been generated
+ * @param indices the indices to load into obj.EBO
+ * post: - obj.EBO holds 'indices' and is the element buffer of obj.VAO
+ *       - obj.count is the number of indices
+ *       - VAOs are unbound
+*/
+void fillElementBuffer(Renderable &obj, const std::vector<unsigned int> &indices){
+    const size_t size = indices.size() * sizeof(unsigned int);
+    obj.count = indices.size();
+    //binding GL_ELEMENT_ARRAY_BUFFER changes the bound VAO, so the VAO has to be bound first
+    glBindVertexArray(obj.VAO);
+    if(obj.EBO == 0){
+        glGenBuffers(1, &obj.EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, obj.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices.data(), GL_STATIC_DRAW);
+    } else{
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, obj.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, NULL, GL_STATIC_DRAW);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size, indices.data());
+    }
+    glBindVertexArray(0);       //unbind VAO 1st to avoid dissociating the bound element buffer
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Loads an indexed sierpinski triangle into the VBO and EBO of a renderable
+ * @param tri the renderable to load the triangle into, with a VAO of 0 if it has not been generated yet
+ * @param vertices the unique vertices of the sierpinski triangle, as filled by initSierpinskiIndexed
+ * @param indices the indices of its triangles, as filled by initSierpinskiIndexed
+ * @param depth the depth the triangle was generated with
+ * post: - tri.VAO reads vertices like sierpinskiOpenGLObj does, from tri.VBO, in the order given
+ *         by tri.EBO
+ *       - tri.count is the number of indices, and tri.depth the depth
+ *       - VAOs and VBOs are unbound
+*/
+void sierpinskiIndexedOpenGLObj(Renderable &tri, const std::vector<vertex_t> &vertices,
+                                const std::vector<unsigned int> &indices, int depth){
+    sierpinskiOpenGLObj(tri, vertices, depth);
+    fillElementBuffer(tri, indices);
+}
+
+/**
+ * Generates a VBO holding the 2d positions of the level 0 triangle, the mesh that every instance
+ * of RENDER_INSTANCED draws
+ * @param VBO a reference to a VBO id
+ * post: VBO holds 3 vertices of 2 floats each, and is unbound
+*/
+void unitTriangleOpenGLObj(unsigned int &VBO){
+    float unitTriangle[] = {
+        -0.5f, -0.5f,   //bottom left
+         0.0f,  0.5f,   //top
+         0.5f, -0.5f    //bottom right
+    };
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(unitTriangle), unitTriangle, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Points a renderable at geometry streamed into a StreamBuffer slot by the current render mode
+ * (RENDER_VERTICES, RENDER_PACKED or RENDER_INSTANCED). The vertex attributes are only set up again
+ * when the slot's buffer object changed, which happens when it had to grow.
+ * @param tri the renderable belonging to the slot, with a VAO of 0 if it has not been generated yet
+ * @param buffer the buffer object of the slot, owned by the StreamBuffer
+ * @param meshVBO the VBO holding the unit triangle (RENDER_INSTANCED), see unitTriangleOpenGLObj
+ * @param depth the depth the geometry was generated with
+ * post: - tri.VAO reads the streamed geometry from 'buffer', which is also stored in tri.VBO
+ *       - tri.count/tri.instanceCount/tri.depth describe the geometry
+ *       - VAOs and VBOs are unbound
+*/
+void sierpinskiStreamedOpenGLObj(Renderable &tri, unsigned int buffer, unsigned int meshVBO, int depth){
+    if(tri.VAO == 0){
+        glGenVertexArrays(1, &tri.VAO);
+    }
+    if(tri.VBO != buffer){
+        glBindVertexArray(tri.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        if(renderMode == RENDER_INSTANCED){
+            instanceAttributes(buffer, meshVBO);
+        } else if(renderMode == RENDER_PACKED){
+            packedVertexAttributes();
+        } else{
+            vertexAttributes();
+        }
+        glBindVertexArray(0);       //unbind VAO
+        glBindBuffer(GL_ARRAY_BUFFER, 0);   //safely unbind VBO without dissasociating it from VAO
+        tri.VBO = buffer;
+    }
+    if(renderMode == RENDER_INSTANCED){
+        tri.count = 3;
+        tri.instanceCount = sierpinskiVertexCount(depth) / 3;
+    } else{
+        tri.count = fractalVertexCount(*fractal, depth);
+        tri.instanceCount = 0;
+    }
+    tri.primitive = GL_TRIANGLES;
+    tri.depth = depth;
+}
+
+/**
+ * Points a renderable at a batch of chaos game points streamed into a StreamBuffer slot. The
+ * vertex attributes are only set up again when the slot's buffer object changed
+ * @param points the renderable belonging to the slot, with a VAO of 0 if it has not been generated yet
+ * @param buffer the buffer object of the slot, holding 2 floats per point
+ * @param count the number of points in the slot
+ * post: - points.VAO reads the points from 'buffer', which is also stored in points.VBO
+ *       - points draws 'count' GL_POINTS
+ *       - VAOs and VBOs are unbound
+*/
+void chaosPointsOpenGLObj(Renderable &points, unsigned int buffer, int count){
+    if(points.VAO == 0){
+        glGenVertexArrays(1, &points.VAO);
+    }
+    if(points.VBO != buffer){
+        glBindVertexArray(points.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        points.VBO = buffer;
+    }
+    points.count = count;
+    points.instanceCount = 0;
+    points.primitive = GL_POINTS;
+    points.depth = 0;
+}
+
+/**
+ * Makes sure the accumulation buffer of RENDER_CHAOS matches the size of the framebuffer,
+ * creating it the first time and starting over whenever the size changes
+ * @param chaos the accumulation buffer
+ * @param width the width of the framebuffer in pixels
+ * @param height the height of the framebuffer in pixels
+ * @return false if there is nothing to draw into (a minimized window) or the buffer could not be created
+ * post: chaos.texture is a width x height R32F texture attached to chaos.FBO, cleared if it was just (re)made
+*/
+bool chaosAccumulationOpenGLObj(ChaosAccumulation &chaos, int width, int height){
+    if(width <= 0 || height <= 0){
+        return false;
+    }
+    if(chaos.width == width && chaos.height == height){
+        return chaos.valid;
+    }
+    if(chaos.FBO == 0){
+        glGenFramebuffers(1, &chaos.FBO);
+        glGenTextures(1, &chaos.texture);
+    }
+    glBindTexture(GL_TEXTURE_2D, chaos.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, chaos.FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, chaos.texture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if(complete){
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    } else{
+        printf("Failed to create a %dx%d float accumulation buffer\n", width, height);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    chaos.width = width;
+    chaos.height = height;
+    chaos.valid = complete;
+    chaos.points = 0.0;
+    return complete;
+}
+
+/**
+ * Sets up a renderable for RENDER_GENERATED, where the vertex shader computes every vertex
+ * @param tri the renderable to set up, with a VAO of 0 if it has not been generated yet
+ * @param depth the depth of the triangle to draw
+ * post: - tri.VAO is an empty VAO, since core profile still needs one bound to draw
+ *       - tri.count is the number of vertices of a triangle of 'depth'
+*/
+void sierpinskiGeneratedOpenGLObj(Renderable &tri, int depth){
+    if(tri.VAO == 0){
+        glGenVertexArrays(1, &tri.VAO);
+    }
+    tri.count = sierpinskiVertexCount(depth);
+    tri.instanceCount = 0;
+    tri.primitive = GL_TRIANGLES;
+    tri.depth = depth;
+}
+
+/**
+ * Rebuilds the frame timing overlay: the min/avg/p99 of every section of the frame over the
+ * last PROFILER_HISTORY frames, in the top left corner of the window, followed by the scratch
+ * memory of the generators (see generatorScratchStats)
+ * @param overlay the renderable to load the text into, with a VAO of 0 if it has not been generated yet
+ * @param vertices the vector the text is built in, reused between updates
+ * @param profiler the profiler timing the frames
+ * post: - overlay draws the text with the default shaders, see fillVertexBuffer
+ *       - VAOs and VBOs are unbound
+*/
+void overlayOpenGLObj(Renderable &overlay, std::vector<vertex_t> &vertices, const FrameProfiler &profiler){
+    const char *names[PROFILE_SECTIONS] = {"INPUT", "GEOMETRY", "DRAW", "SWAP", "GPU"};
+    const float pixelWidth = 2.0f * OVERLAY_PIXEL / std::max(1, framebufferWidth);
+    const float pixelHeight = 2.0f * OVERLAY_PIXEL / std::max(1, framebufferHeight);
+    const float lineHeight = (GLYPH_HEIGHT + 3) * pixelHeight;
+    const float left = -1.0f + 4 * pixelWidth;
+    float top = 1.0f - 4 * pixelHeight;
+
+    vertices.clear();
+    appendOverlayText(vertices, "MS         MIN    AVG    P99", left, top, pixelWidth, pixelHeight, 1.0f, 1.0f, 0.5f);
+    for(int i = 0; i < PROFILE_SECTIONS; i++){
+        ProfileStats stats = profiler.stats((ProfileSection)i);
+        char line[64];
+        snprintf(line, sizeof(line), "%-8s %6.2f %6.2f %6.2f", names[i], stats.min, stats.avg, stats.p99);
+        top -= lineHeight;
+        appendOverlayText(vertices, line, left, top, pixelWidth, pixelHeight, 1.0f, 1.0f, 1.0f);
+    }
+    //scratch memory the generators keep between rebuilds, and the most they ever used
+    scratch_stats_t scratch = generatorScratchStats();
+    char line[64];
+    snprintf(line, sizeof(line), "SCRATCH MB %6.1f PEAK %6.1f", scratch.reserved / 1048576.0, scratch.highWater / 1048576.0);
+    top -= lineHeight;
+    appendOverlayText(vertices, line, left, top, pixelWidth, pixelHeight, 1.0f, 1.0f, 0.5f);
+
+    overlay.count = vertices.size();
+    overlay.instanceCount = 0;
+    overlay.primitive = GL_TRIANGLES;
+    overlay.depth = 0;
+    if(fillVertexBuffer(overlay, vertices.data(), vertices.size() * sizeof(vertex_t))){
+        vertexAttributes();
+        glBindVertexArray(0);       //unbind VAO
+        glBindBuffer(GL_ARRAY_BUFFER, 0);   //safely unbind VBO without dissasociating it from VAO
+    }
+}
 
 /**
  * Generates VAOs/VBOs/EBOs for the background rectangle
@@ -314,12 +3064,25 @@ void backgroundOpenGLObj(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(drawOrder), drawOrder, GL_STATIC_DRAW);
     
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*) 0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*) 0);
-    glEnableVertexAttribArray(1);
+    backgroundAttributes(VBO, EBO);
 
     glBindVertexArray(0);       //unbind VAO 1st to avoid dissociating bound array/element buffers
     glBindBuffer(GL_ARRAY_BUFFER, 0);   //safely unbind VBOs w/o dissociating from VAO
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);   //safely unbind EBOs w/o dissociating from VAO
 }
+
+/**
+ * Sets up the vertex attributes of the background rectangle, see backgroundOpenGLObj
+ * @param VBO the buffer holding the corners of the rectangle
+ * @param EBO the buffer holding its draw order
+ * pre: the VAO to set up is bound
+ * post: attributes 0 and 1 read from VBO, and EBO is the VAO's element buffer
+*/
+void backgroundAttributes(unsigned int VBO, unsigned int EBO){
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*) 0);
+    glEnableVertexAttribArray(1);
+}
@@ -1,5 +1,52 @@
+#ifndef MYTYPES_H
+#define MYTYPES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
 typedef struct{
     float x, y, z;
 } point_t;
 
-point_t midpoint(point_t a, point_t b);
\ No newline at end of file
+typedef struct{
+    float x, y, z;      //position
+    float r, g, b;      //color
+} vertex_t;
+
+typedef struct{
+    short x, y;                 //position, normalized so 32767 is 1.0
+    unsigned char depth;        //depth level, the vertex shader turns it into a color
+    unsigned char pad[3];       //keeps every vertex 4 byte aligned
+} packed_vertex_t;
+
+typedef struct{
+    float x, y;         //offset of the unit triangle
+    float scale;        //size relative to the unit triangle
+    float depth;        //depth level of the sub-triangle
+} instance_t;
+
+typedef struct{
+    float *ax, *ay;     //first corner of every triangle
+    float *bx, *by;     //second corner
+    float *cx, *cy;     //third corner
+    size_t count;       //number of triangles
+} triangles_t;          //structure of arrays holding the 2d corners of many triangles
+
+typedef struct{
+    double ax, ay;      //first corner
+    double bx, by;      //second corner
+    double cx, cy;      //third corner
+} dtriangle_t;          //2d triangle in double precision, for positions deeper than floats can hold
+
+typedef struct{
+    uint32_t s[4];      //xoshiro128** state, never all zero
+} xoshiro128_t;         //small fast random number generator, see chaosGame
+
+typedef struct{
+    float x, y;         //current point of the walk
+    xoshiro128_t rng;   //picks the corner every jump goes towards
+} chaos_walker_t;       //one walk of the chaos game, see chaosGame
+
+point_t midpoint(point_t a, point_t b);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+/**
+ * Functions used to draw text on top of the window, for the frame timing overlay
+ * 
+*/
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include<vector>
+#include "mytypes.h"
+
+#define GLYPH_WIDTH 5       //pixels across a glyph of the overlay font
+#define GLYPH_HEIGHT 7      //pixels down a glyph of the overlay font
+
+/**
+ * Finds the bitmap of a character of the overlay font, a 5x7 font covering digits, upper case
+ * letters (lower case ones are drawn as upper case) and a few symbols
+ * @param c the character to look up
+ * @return GLYPH_HEIGHT rows from top to bottom, the highest of the GLYPH_WIDTH bits of a row
+ *         being its leftmost pixel. Characters the font doesn't have are drawn blank
+*/
+inline const unsigned char *overlayGlyph(char c){
+    static const unsigned char blank[GLYPH_HEIGHT] = {0};
+    static const unsigned char digits[10][GLYPH_HEIGHT] = {
+        {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},     //0
+        {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},     //1
+        {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},     //2
+        {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},     //3
+        {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},     //4
+        {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},     //5
+        {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},     //6
+        {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},     //7
+        {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},     //8
+        {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}      //9
+    };
+    static const unsigned char letters[26][GLYPH_HEIGHT] = {
+        {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},     //A
+        {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E},     //B
+        {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},     //C
+        {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C},     //D
+        {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F},     //E
+        {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},     //F
+        {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F},     //G
+        {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},     //H
+        {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},     //I
+        {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C},     //J
+        {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},     //K
+        {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F},     //L
+        {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11},     //M
+        {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},     //N
+        {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},     //O
+        {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10},     //P
+        {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D},     //Q
+        {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11},     //R
+        {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E},     //S
+        {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},     //T
+        {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},     //U
+        {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04},     //V
+        {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A},     //W
+        {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11},     //X
+        {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04},     //Y
+        {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}      //Z
+    };
+    static const unsigned char period[GLYPH_HEIGHT] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C};
+    static const unsigned char colon[GLYPH_HEIGHT] = {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00};
+    static const unsigned char dash[GLYPH_HEIGHT] = {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00};
+    static const unsigned char slash[GLYPH_HEIGHT] = {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00};
+
+    if(c >= '0' && c <= '9'){
+        return digits[c - '0'];
+    } else if(c >= 'A' && c <= 'Z'){
+        return letters[c - 'A'];
+    } else if(c >= 'a' && c <= 'z'){
+        return letters[c - 'a'];
+    } else if(c == '.'){
+        return period;
+    } else if(c == ':'){
+        return colon;
+    } else if(c == '-'){
+        return dash;
+    } else if(c == '/'){
+        return slash;
+    }
+    return blank;
+}
+
+/**
+ * Adds the triangles drawing a line of text in the overlay font, one quad per lit font pixel
+ * @param vertices the vector to add the vertices to, 6 per lit pixel
+ * @param text the text to draw, on a single line
+ * @param x left edge of the text, in normalized device coordinates
+ * @param y top edge of the text, in normalized device coordinates
+ * @param pixelWidth width of a font pixel, in normalized device coordinates
+ * @param pixelHeight height of a font pixel, in normalized device coordinates
+ * @param r red component of the text color
+ * @param g green component of the text color
+ * @param b blue component of the text color
+ * post: the text is at the end of 'vertices', drawn with GL_TRIANGLES by the default shaders
+*/
+inline void appendOverlayText(std::vector<vertex_t> &vertices, const char *text, float x, float y,
+                              float pixelWidth, float pixelHeight, float r, float g, float b){
+    for(; *text != '\0'; text++){
+        const unsigned char *glyph = overlayGlyph(*text);
+        for(int row = 0; row < GLYPH_HEIGHT; row++){
+            for(int column = 0; column < GLYPH_WIDTH; column++){
+                if(!(glyph[row] & (1 << (GLYPH_WIDTH - 1 - column)))){
+                    continue;
+                }
+                float left = x + column * pixelWidth, right = left + pixelWidth;
+                float top = y - row * pixelHeight, bottom = top - pixelHeight;
+                vertex_t quad[6] = {
+                    {left, bottom, 0.0f, r, g, b}, {right, bottom, 0.0f, r, g, b}, {right, top, 0.0f, r, g, b},
+                    {left, bottom, 0.0f, r, g, b}, {right, top, 0.0f, r, g, b}, {left, top, 0.0f, r, g, b}
+                };
+                vertices.insert(vertices.end(), quad, quad + 6);
+            }
+        }
+        x += (GLYPH_WIDTH + 1) * pixelWidth;    //one blank column between glyphs
+    }
+}
+
+#endif
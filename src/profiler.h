@@ -0,0 +1,276 @@
+/**
+ * Class used to time the frames of the render loop
+ * 
+*/
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include<glad/glad.h>   //get required OpenGL headers
+
+#include<stdio.h>
+#include<string.h>
+#include<chrono>
+#include<vector>
+#include<algorithm>
+
+#define PROFILER_HISTORY 240        //frames kept for the min/avg/p99 aggregates
+#define PROFILER_QUERIES 4          //GPU timer queries in flight, so reading one never waits on the GPU
+
+/**
+ * The parts of a frame timed on the CPU, plus the GPU time of the draws
+ * PROFILE_INPUT: processing input and shader reloads
+ * PROFILE_GEOMETRY: starting, collecting and uploading geometry
+ * PROFILE_DRAW: submitting the draw calls
+ * PROFILE_SWAP: swapping buffers and polling events, which includes waiting on vsync and the frame limiter
+ * PROFILE_GPU: time the GPU spent on the draws, from GL_TIME_ELAPSED queries
+*/
+enum ProfileSection{
+    PROFILE_INPUT,
+    PROFILE_GEOMETRY,
+    PROFILE_DRAW,
+    PROFILE_SWAP,
+    PROFILE_GPU,
+    PROFILE_SECTIONS
+};
+
+/**
+ * Aggregates of one section over the last PROFILER_HISTORY frames, in milliseconds
+*/
+struct ProfileStats{
+    double min = 0.0;
+    double avg = 0.0;
+    double p99 = 0.0;
+};
+
+class FrameProfiler{
+    public:
+        /**
+         * Constructor for a FrameProfiler
+         * pre: an OpenGL context is current
+         * post: FrameProfiler constructed with an empty history and its GPU queries generated
+        */
+        FrameProfiler(){
+            glGenQueries(PROFILER_QUERIES, queries);
+            for(int i = 0; i < PROFILER_QUERIES; i++){
+                queryFrame[i] = -1;
+            }
+            history.resize(PROFILER_HISTORY);
+        }
+
+        /**
+         * Deconstructor for the FrameProfiler.
+         * Deletes the GPU queries and closes the log
+        */
+        ~FrameProfiler(){
+            closeLog();
+            glDeleteQueries(PROFILER_QUERIES, queries);
+        }
+
+        FrameProfiler(const FrameProfiler &) = delete;
+        FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+        /**
+         * Starts writing every frame to a log file, as CSV or, if the path ends in .json, as a JSON array
+         * @param path the path of the log file
+         * @return false if the file could not be opened
+        */
+        bool openLog(const char *path){
+            closeLog();
+            log = fopen(path, "w");
+            if(log == NULL){
+                printf("\nERROR OPENING PROFILE LOG %s\n", path);
+                return false;
+            }
+            size_t length = strlen(path);
+            json = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+            if(json){
+                fprintf(log, "[\n");
+            } else{
+                fprintf(log, "frame,input_ms,geometry_ms,draw_ms,swap_ms,gpu_ms\n");
+            }
+            return true;
+        }
+
+        /**
+         * Finishes the log file, if open
+        */
+        void closeLog(){
+            if(log == NULL){
+                return;
+            }
+            if(json){
+                fprintf(log, "\n]\n");
+            }
+            fclose(log);
+            log = NULL;
+        }
+
+        /**
+         * Starts timing a frame
+         * post: the frame's CPU sections are timed from now on
+        */
+        void beginFrame(){
+            current = Sample();
+            last = std::chrono::steady_clock::now();
+        }
+
+        /**
+         * Ends a CPU section of the frame
+         * @param section the section that just ended, it gets the time since the previous mark
+        */
+        void mark(ProfileSection section){
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            current.ms[section] += std::chrono::duration<double, std::milli>(now - last).count();
+            last = now;
+        }
+
+        /**
+         * Starts timing the GPU work of the frame. If the query this frame would use still hasn't
+         * got a result, this frame just isn't timed on the GPU rather than waiting on it
+         * pre: no other GL_TIME_ELAPSED query is active
+        */
+        void beginGPU(){
+            int slot = frame % PROFILER_QUERIES;
+            readQuery(slot);
+            gpuActive = queryFrame[slot] == -1;
+            if(gpuActive){
+                glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+            }
+        }
+
+        /**
+         * Stops timing the GPU work of the frame
+        */
+        void endGPU(){
+            if(gpuActive){
+                glEndQuery(GL_TIME_ELAPSED);
+                queryFrame[frame % PROFILER_QUERIES] = frame;
+                gpuActive = false;
+            }
+        }
+
+        /**
+         * Ends timing a frame
+         * post: the frame is in the history, and in the log if one is open. Its GPU time is
+         *       filled in once its query has a result, a few frames later
+        */
+        void endFrame(){
+            for(int i = 0; i < PROFILER_QUERIES; i++){
+                readQuery(i);
+            }
+            history[frame % PROFILER_HISTORY] = current;
+            frame++;
+            if(log != NULL && frame > PROFILER_QUERIES){
+                //log frames once their GPU time can be in, the last few frames are never logged
+                writeLogRow(frame - 1 - PROFILER_QUERIES);
+            }
+        }
+
+        /**
+         * @param section the section to get the statistics of
+         * @return the min/avg/p99 of the section over the last PROFILER_HISTORY frames
+        */
+        ProfileStats stats(ProfileSection section) const{
+            std::vector<double> values;
+            long long first = std::max(0LL, frame - PROFILER_HISTORY);
+            for(long long i = first; i < frame; i++){
+                const Sample &sample = history[i % PROFILER_HISTORY];
+                if(section != PROFILE_GPU || sample.gpuValid){
+                    values.push_back(sample.ms[section]);
+                }
+            }
+            ProfileStats result;
+            if(values.empty()){
+                return result;
+            }
+            std::sort(values.begin(), values.end());
+            result.min = values.front();
+            for(double value : values){
+                result.avg += value;
+            }
+            result.avg /= values.size();
+            result.p99 = values[std::min(values.size() - 1, (size_t)(values.size() * 0.99))];
+            return result;
+        }
+
+        /**
+         * Prints the min/avg/p99 of every section
+        */
+        void printStats() const{
+            const char *names[PROFILE_SECTIONS] = {"input", "geometry", "draw", "swap", "gpu"};
+            printf("\nframe times over the last %lld frames (ms): min / avg / p99\n",
+                   std::min(frame, (long long)PROFILER_HISTORY));
+            for(int i = 0; i < PROFILE_SECTIONS; i++){
+                ProfileStats s = stats((ProfileSection)i);
+                printf("%10s %8.3f %8.3f %8.3f\n", names[i], s.min, s.avg, s.p99);
+            }
+        }
+
+    private:
+        /**
+         * ms: time spent in every section, in milliseconds
+         * gpuValid: true once ms[PROFILE_GPU] holds a query result
+        */
+        struct Sample{
+            double ms[PROFILE_SECTIONS] = {};
+            bool gpuValid = false;
+        };
+
+        std::vector<Sample> history;                //ring of the last PROFILER_HISTORY frames
+        Sample current;                             //the frame being timed
+        long long frame = 0;                        //number of frames ended so far
+        std::chrono::steady_clock::time_point last; //time of the last mark
+        unsigned int queries[PROFILER_QUERIES];     //ring of GL_TIME_ELAPSED queries
+        long long queryFrame[PROFILER_QUERIES];     //frame each query is timing, -1 if it is free
+        bool gpuActive = false;                     //true between beginGPU and endGPU if timed
+        FILE *log = NULL;
+        bool json = false;
+
+        /**
+         * private helper function that stores the result of a query if the GPU has it ready
+         * @param slot the query to read
+         * post: if the result was ready, it is in the history and the query is free again
+        */
+        void readQuery(int slot){
+            if(queryFrame[slot] == -1){
+                return;
+            }
+            int available = 0;
+            glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available){
+                return;
+            }
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &ns);
+            long long timed = queryFrame[slot];
+            if(frame - timed <= PROFILER_HISTORY - 1 || timed == frame){
+                Sample &sample = timed == frame ? current : history[timed % PROFILER_HISTORY];
+                sample.ms[PROFILE_GPU] = ns / 1.0e6;
+                sample.gpuValid = true;
+            }
+            queryFrame[slot] = -1;
+        }
+
+        /**
+         * private helper function that writes a frame of the history to the log
+         * @param index the number of the frame
+        */
+        void writeLogRow(long long index){
+            const Sample &s = history[index % PROFILER_HISTORY];
+            char gpu[32] = "";
+            if(s.gpuValid){
+                snprintf(gpu, sizeof(gpu), "%.4f", s.ms[PROFILE_GPU]);
+            }
+            if(json){
+                fprintf(log, "%s{\"frame\": %lld, \"input_ms\": %.4f, \"geometry_ms\": %.4f, \"draw_ms\": %.4f, "
+                             "\"swap_ms\": %.4f, \"gpu_ms\": %s}",
+                        index == 0 ? "" : ",\n", index, s.ms[PROFILE_INPUT], s.ms[PROFILE_GEOMETRY],
+                        s.ms[PROFILE_DRAW], s.ms[PROFILE_SWAP], s.gpuValid ? gpu : "null");
+            } else{
+                fprintf(log, "%lld,%.4f,%.4f,%.4f,%.4f,%s\n", index, s.ms[PROFILE_INPUT], s.ms[PROFILE_GEOMETRY],
+                        s.ms[PROFILE_DRAW], s.ms[PROFILE_SWAP], gpu);
+            }
+        }
+};
+
+#endif
@@ -12,8 +12,63 @@
 #include<fstream>
 #include<sstream>
 #include<string>
+#include<unordered_map>
+#include<sys/stat.h>    //file modification times, to notice edited shaders
 
 #define SHADER_PROGRAM 0xDEADBEEF
+#define SHADER_CACHE_PREFIX "shadercache-"   //program binaries are cached in files named SHADER_CACHE_PREFIX<hash>.bin
+
+//float vectors and a column major 4x4 matrix, laid out like their GLSL counterparts
+struct vec2_t{
+    float x, y;
+};
+struct vec3_t{
+    float x, y, z;
+};
+struct vec4_t{
+    float x, y, z, w;
+};
+struct mat4_t{
+    float m[16];
+};
+
+class Shader;
+
+/**
+ * Handle to a uniform of a Shader, with its location already looked up. Setting it never does
+ * a string lookup, so it is the way to set uniforms that change every frame.
+ * It refers to the Shader's cached location rather than copying it, so it stays valid if the
+ * Shader is relinked.
+ * T is one of bool, int, float, vec2_t, vec3_t, vec4_t or mat4_t
+*/
+template<typename T>
+class Uniform{
+    public:
+        /**
+         * Constructor for a Uniform that refers to nothing, setting it does nothing
+        */
+        Uniform() : shader(NULL), location(NULL){}
+
+        /**
+         * @param value the value we want to change the uniform to
+         * pre: the shader is in use, unless the context is GL 4.1+ (see Shader::set)
+        */
+        void set(const T &value) const;
+
+        /**
+         * @param values the values we want to change the elements of a uniform array to
+         * @param count the number of elements in 'values'
+         * pre: the shader is in use, unless the context is GL 4.1+ (see Shader::set)
+        */
+        void set(const T *values, int count) const;
+
+    private:
+        friend class Shader;
+        const Shader *shader;   //shader the uniform belongs to
+        const int *location;    //the shader's cached location of the uniform
+
+        Uniform(const Shader *shader, const int *location) : shader(shader), location(location){}
+};
 
 class Shader{
     public:
@@ -29,40 +84,8 @@ class Shader{
          *       shaders specified in the paths given to the constructor.
         */
         Shader(const char *vShaderPath, const char *fShaderPath){
-            //1. retrieve source code from path(s)
-            std::string vertexCode = getFileContents(vShaderPath);
-            std::string fragmentCode = getFileContents(fShaderPath);
-
-            //convert to C-style strings since
-            //openGL only recognizes them as valid shader programs
-            const char *vShaderSourceCode = vertexCode.c_str();
-            const char *fShaderSourceCode = fragmentCode.c_str();
-
-            //2. compile and link shaders
-            unsigned int vert, frag;
-            //compile vertex shader
-            vert = glCreateShader(GL_VERTEX_SHADER);
-            glShaderSource(vert, 1, &vShaderSourceCode, NULL);
-            glCompileShader(vert);
-            checkError(vert, GL_VERTEX_SHADER);
-
-            //compile fragment shader
-            frag = glCreateShader(GL_FRAGMENT_SHADER);
-            glShaderSource(frag, 1, &fShaderSourceCode, NULL);
-            glCompileShader(frag);
-            checkError(frag, GL_FRAGMENT_SHADER);
-
-
-            //link shaders
-            programID = glCreateProgram();
-            glAttachShader(programID, vert);
-            glAttachShader(programID, frag);
-            glLinkProgram(programID);
-            checkError(programID, SHADER_PROGRAM);
-
-            //delete unused shaders
-            glDeleteShader(vert);
-            glDeleteShader(frag);
+            programID = 0;
+            setShaders(vShaderPath, fShaderPath);
         }
 
         /**
@@ -75,16 +98,88 @@ class Shader{
                 programID = 0;
             }
         }
+
+        //Uniform handles point into a Shader, so it must stay where it is
+        Shader(const Shader &) = delete;
+        Shader &operator=(const Shader &) = delete;
         
         /**
          * @param vPath the path to the file w/ vertex shader source code
          * @param fPath the path to a file w/ fragment shader source code
          * pre: vPath & fPath are valid directories
          * post: this shader object now refers to a shader program linking
-         *       the shaders specified by the given paths
+         *       the shaders specified by the given paths, and the old program is deleted.
+         *       If the new program fails to build, the errors are printed and the old one is kept
         */
         void setShaders(const char *vPath, const char *fPath){
-            *this = Shader(vPath, fPath);
+            vertexPath = vPath;
+            fragmentPath = fPath;
+            sourcesChanged();   //remember the current modification times
+            replaceProgram(buildProgram());
+        }
+
+        /**
+         * Checks whether either shader file was modified since the last call (or since they were loaded)
+         * @return true if a file changed, followed by a buildProgram/replaceProgram to pick up the change
+         * post: the modification times are remembered, so each change is reported once
+        */
+        bool sourcesChanged(){
+            long long vTime = modificationTime(vertexPath.c_str());
+            long long fTime = modificationTime(fragmentPath.c_str());
+            bool changed = vTime != vertexTime || fTime != fragmentTime;
+            vertexTime = vTime;
+            fragmentTime = fTime;
+            return changed;
+        }
+
+        /**
+         * Builds a new program from the shader files, through the program binary cache.
+         * It doesn't touch this Shader, so it may run on another thread that has a context
+         * sharing objects with the one the Shader is used from
+         * @return the id of the linked program, or 0 if it failed to compile or link (the errors are printed)
+         * pre: an OpenGL context is current on the calling thread
+         * post: if the program was linked from source, its binary is cached
+        */
+        unsigned int buildProgram() const{
+            //1. retrieve source code from path(s)
+            std::string vertexCode = getFileContents(vertexPath.c_str());
+            std::string fragmentCode = getFileContents(fragmentPath.c_str());
+
+            //2. reuse the program binary from the last run if neither the sources nor the driver
+            //   changed, otherwise compile and link the sources and cache the result
+            std::string cachePath = binaryCachePath(vertexPath.c_str(), fragmentPath.c_str());
+            unsigned long long key = binaryCacheKey(vertexCode, fragmentCode);
+            unsigned int program = loadProgramBinary(cachePath, key);
+            if(program == 0){
+                program = compileProgram(vertexCode, fragmentCode);
+                if(program != 0){
+                    saveProgramBinary(program, cachePath, key);
+                }
+            }
+            return program;
+        }
+
+        /**
+         * Swaps in a program built by buildProgram, deleting the old one. Existing Uniform
+         * handles keep working, but handles made for uniforms the old program didn't have
+         * are still empty and have to be made again
+         * @param program the new program, 0 to keep the current one
+         * @return true if the program was replaced
+         * pre: if program was built on another context, that context has finished building it (glFinish)
+         * post: - programID is 'program', and the uniform locations are those of the new program
+         *       - every uniform of the new program is at its default (0), so values the old one
+         *         held have to be set again
+        */
+        bool replaceProgram(unsigned int program){
+            if(program == 0){
+                return false;
+            }
+            if(programID != 0){
+                glDeleteProgram(programID);
+            }
+            programID = program;
+            cacheUniformLocations();
+            return true;
         }
 
         /**
@@ -98,13 +193,91 @@ class Shader{
             glUseProgram(programID);
         }
 
-        //modifier methods to set uniform shader attributes
+        /**
+         * @param name the name of a uniform, without [0] for arrays
+         * @return the location of the uniform, looked up once when the program was linked,
+         *         or -1 if the program has no active uniform called 'name'
+        */
+        int uniformLocation(const std::string &name) const{
+            auto it = uniforms.find(name);
+            return it == uniforms.end() ? -1 : it->second;
+        }
+
+        /**
+         * @param name the name of a uniform, without [0] for arrays
+         * @return a handle that sets the uniform without looking it up again, which does nothing
+         *         if the program has no active uniform called 'name'
+        */
+        template<typename T>
+        Uniform<T> uniform(const std::string &name) const{
+            auto it = uniforms.find(name);
+            return it == uniforms.end() ? Uniform<T>() : Uniform<T>(this, &it->second);
+        }
+
+        /**
+         * Sets a uniform (or the first 'count' elements of a uniform array) of this program.
+         * On GL 4.1+ this uses glProgramUniform, so the program doesn't have to be in use
+         * @param location the location of the uniform, -1 is silently ignored like OpenGL does
+         * @param values the values we want to change the uniform to
+         * @param count the number of elements in 'values'
+         * pre: this shader is in use, unless the context is GL 4.1+
+        */
+        void set(int location, const bool *values, int count) const{
+            for(int i = 0; i < count && location != -1; i++){
+                int value = values[i];
+                set(location + i, &value, 1);
+            }
+        }
+        void set(int location, const int *values, int count) const{
+            if(GLAD_GL_VERSION_4_1){
+                glProgramUniform1iv(programID, location, count, values);
+            } else{
+                glUniform1iv(location, count, values);
+            }
+        }
+        void set(int location, const float *values, int count) const{
+            if(GLAD_GL_VERSION_4_1){
+                glProgramUniform1fv(programID, location, count, values);
+            } else{
+                glUniform1fv(location, count, values);
+            }
+        }
+        void set(int location, const vec2_t *values, int count) const{
+            if(GLAD_GL_VERSION_4_1){
+                glProgramUniform2fv(programID, location, count, &values->x);
+            } else{
+                glUniform2fv(location, count, &values->x);
+            }
+        }
+        void set(int location, const vec3_t *values, int count) const{
+            if(GLAD_GL_VERSION_4_1){
+                glProgramUniform3fv(programID, location, count, &values->x);
+            } else{
+                glUniform3fv(location, count, &values->x);
+            }
+        }
+        void set(int location, const vec4_t *values, int count) const{
+            if(GLAD_GL_VERSION_4_1){
+                glProgramUniform4fv(programID, location, count, &values->x);
+            } else{
+                glUniform4fv(location, count, &values->x);
+            }
+        }
+        void set(int location, const mat4_t *values, int count) const{
+            if(GLAD_GL_VERSION_4_1){
+                glProgramUniformMatrix4fv(programID, location, count, GL_FALSE, values->m);
+            } else{
+                glUniformMatrix4fv(location, count, GL_FALSE, values->m);
+            }
+        }
+
+        //modifier methods to set uniform shader attributes by name, see set for when the shader has to be in use
         /**
          * @param name the name of the uniform attribute we want to set
          * @param value the value we want to change the uniform attribute to 
         */
         void setBool(const std::string &name, bool value) const{
-            glUniform1i(glGetUniformLocation(programID, name.c_str()), (int)value); 
+            set(uniformLocation(name), &value, 1);
         }
 
         /**
@@ -112,7 +285,7 @@ class Shader{
          * @param value the value we want to change the uniform attribute to 
         */
         void setInt(const std::string &name, int value) const{
-            glUniform1i(glGetUniformLocation(programID, name.c_str()), value);
+            set(uniformLocation(name), &value, 1);
         }
 
         /**
@@ -120,10 +293,254 @@ class Shader{
          * @param value the value we want to change the uniform attribute to 
         */
         void setFloat(const std::string &name, float value) const{
-            glUniform1f(glGetUniformLocation(programID, name.c_str()), value);
+            set(uniformLocation(name), &value, 1);
+        }
+
+        /**
+         * @param name the name of the uniform attribute we want to set
+         * @param value the value we want to change the uniform attribute to 
+        */
+        void setVec2(const std::string &name, const vec2_t &value) const{
+            set(uniformLocation(name), &value, 1);
+        }
+
+        /**
+         * @param name the name of the uniform attribute we want to set
+         * @param value the value we want to change the uniform attribute to 
+        */
+        void setVec3(const std::string &name, const vec3_t &value) const{
+            set(uniformLocation(name), &value, 1);
+        }
+
+        /**
+         * @param name the name of the uniform attribute we want to set
+         * @param value the value we want to change the uniform attribute to 
+        */
+        void setVec4(const std::string &name, const vec4_t &value) const{
+            set(uniformLocation(name), &value, 1);
+        }
+
+        /**
+         * @param name the name of the uniform attribute we want to set
+         * @param value the value we want to change the uniform attribute to, column major
+        */
+        void setMat4(const std::string &name, const mat4_t &value) const{
+            set(uniformLocation(name), &value, 1);
         }
 
     private:
+        std::string vertexPath, fragmentPath;   //paths the program is built from
+        long long vertexTime = -1;              //modification times of the files, -1 if missing
+        long long fragmentTime = -1;
+
+        /**
+         * private helper function that gets the modification time of a file
+         * @param path the path to the file
+         * @return the modification time in seconds, -1 if the file can't be found
+        */
+        static long long modificationTime(const char *path){
+            struct stat info;
+            if(stat(path, &info) != 0){
+                return -1;
+            }
+            return (long long)info.st_mtime;
+        }
+
+        /**
+         * private helper function that compiles and links a program from source
+         * @param vertexCode the source code of the vertex shader
+         * @param fragmentCode the source code of the fragment shader
+         * @return the id of a shader program linking both shaders, or 0 if compiling or linking
+         *         failed, in which case the errors are printed
+        */
+        unsigned int compileProgram(const std::string &vertexCode, const std::string &fragmentCode) const{
+            //convert to C-style strings since
+            //openGL only recognizes them as valid shader programs
+            const char *vShaderSourceCode = vertexCode.c_str();
+            const char *fShaderSourceCode = fragmentCode.c_str();
+
+            unsigned int vert, frag;
+            //compile vertex shader
+            vert = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(vert, 1, &vShaderSourceCode, NULL);
+            glCompileShader(vert);
+            bool success = checkError(vert, GL_VERTEX_SHADER);
+
+            //compile fragment shader
+            frag = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(frag, 1, &fShaderSourceCode, NULL);
+            glCompileShader(frag);
+            success = checkError(frag, GL_FRAGMENT_SHADER) && success;
+
+
+            //link shaders
+            unsigned int program = glCreateProgram();
+            if(GLAD_GL_VERSION_4_1){
+                glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+            glAttachShader(program, vert);
+            glAttachShader(program, frag);
+            glLinkProgram(program);
+            success = success && checkError(program, SHADER_PROGRAM);
+
+            //delete unused shaders
+            glDeleteShader(vert);
+            glDeleteShader(frag);
+            if(!success){
+                glDeleteProgram(program);
+                return 0;
+            }
+            return program;
+        }
+
+        /**
+         * private helper function that hashes a string with 64 bit FNV-1a
+         * @param text the string to hash
+         * @param hash the hash to continue from, so several strings can be hashed as one
+         * @return the hash of 'text'
+        */
+        static unsigned long long hashString(const std::string &text, unsigned long long hash = 14695981039346656037ULL){
+            for(unsigned char c : text){
+                hash = (hash ^ c) * 1099511628211ULL;
+            }
+            return (hash ^ 0xFF) * 1099511628211ULL;   //separator, so "ab"+"c" and "a"+"bc" differ
+        }
+
+        /**
+         * private helper function that names the file the binary of a program is cached in
+         * @param vShaderPath the path to the vertex shader
+         * @param fShaderPath the path to the fragment shader
+         * @return the path of the cache file, one per pair of shader paths
+        */
+        static std::string binaryCachePath(const char *vShaderPath, const char *fShaderPath){
+            char name[64];
+            snprintf(name, sizeof(name), SHADER_CACHE_PREFIX "%016llx.bin",
+                     hashString(fShaderPath, hashString(vShaderPath)));
+            return name;
+        }
+
+        /**
+         * private helper function that works out the key a cached program binary has to match
+         * @param vertexCode the source code of the vertex shader
+         * @param fragmentCode the source code of the fragment shader
+         * @return a hash of the sources and of the driver vendor, renderer and version strings,
+         *         since a binary is only valid for the driver that made it
+         * pre: an OpenGL context is current
+        */
+        static unsigned long long binaryCacheKey(const std::string &vertexCode, const std::string &fragmentCode){
+            unsigned long long key = hashString(fragmentCode, hashString(vertexCode));
+            const GLenum driverStrings[3] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+            for(GLenum driverString : driverStrings){
+                const char *value = (const char *)glGetString(driverString);
+                key = hashString(value != NULL ? value : "", key);
+            }
+            return key;
+        }
+
+        /**
+         * private helper function that creates the program from a cached binary
+         * @param path the path of the cache file
+         * @param key the key the cached binary has to have been saved with
+         * @return the id of the program created from the cache, 0 if there is no cache file,
+         *         it was saved for other sources or another driver, or the driver rejected it
+        */
+        unsigned int loadProgramBinary(const std::string &path, unsigned long long key) const{
+            if(!GLAD_GL_VERSION_4_1){
+                return 0;
+            }
+            std::ifstream file(path, std::ios::binary);
+            unsigned long long fileKey = 0;
+            unsigned int format = 0, length = 0;
+            file.read((char *)&fileKey, sizeof(fileKey));
+            file.read((char *)&format, sizeof(format));
+            file.read((char *)&length, sizeof(length));
+            if(!file || fileKey != key){
+                return 0;
+            }
+            std::string binary(length, '\0');
+            if(!file.read(&binary[0], length)){
+                return 0;
+            }
+
+            unsigned int program = glCreateProgram();
+            glProgramBinary(program, format, binary.data(), length);
+            int success;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if(!success){
+                //the driver can still refuse a binary it made, e.g. after an update that kept its version string
+                glDeleteProgram(program);
+                return 0;
+            }
+            return program;
+        }
+
+        /**
+         * private helper function that writes the binary of a program to the cache
+         * @param program the id of a program linked from source
+         * @param path the path of the cache file
+         * @param key the key to save the binary with, see binaryCacheKey
+         * post: the cache file holds the program binary, unless the driver doesn't support any
+         *       binary formats or linking failed
+        */
+        void saveProgramBinary(unsigned int program, const std::string &path, unsigned long long key) const{
+            if(!GLAD_GL_VERSION_4_1){
+                return;
+            }
+            int success, formats, length;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+            if(!success || formats == 0 || length <= 0){
+                return;
+            }
+            std::string binary(length, '\0');
+            unsigned int format = 0;
+            glGetProgramBinary(program, length, &length, &format, &binary[0]);
+
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            unsigned int fileLength = length;
+            file.write((const char *)&key, sizeof(key));
+            file.write((const char *)&format, sizeof(format));
+            file.write((const char *)&fileLength, sizeof(fileLength));
+            file.write(binary.data(), length);
+            if(!file){
+                printf("\nERROR WRITING SHADER CACHE %s\n", path.c_str());
+            }
+        }
+
+        //location of every active uniform, keyed by name. Entries are only ever updated, never
+        //erased, so the pointers held by Uniform handles stay valid
+        std::unordered_map<std::string, int> uniforms;
+
+        /**
+         * private helper function that looks up the location of every active uniform of the
+         * program once, so setting a uniform never has to
+         * pre: programID refers to a linked program
+         * post: uniforms holds the location of every active uniform, uniforms the program
+         *       no longer has are set to -1
+        */
+        void cacheUniformLocations(){
+            for(auto &entry : uniforms){
+                entry.second = -1;
+            }
+            int count = 0;
+            glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+            for(int i = 0; i < count; i++){
+                char name[256];
+                int length, size;
+                unsigned int type;
+                glGetActiveUniform(programID, i, sizeof(name), &length, &size, &type, name);
+                //arrays are reported as "name[0]", but we look them up by "name"
+                std::string key(name, length);
+                if(key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0){
+                    key.resize(key.size() - 3);
+                }
+                int location = glGetUniformLocation(programID, name);
+                if(location != -1){     //uniforms in blocks have no location
+                    uniforms[key] = location;
+                }
+            }
+        }
 
         /**
          * private helper function that takes a path to a file, and returns the contents
@@ -133,7 +550,7 @@ class Shader{
          * pre: path is a valid path to a file
          * post: return the contents of that file inside a std::string object
         */
-        std::string getFileContents(const char *path){
+        std::string getFileContents(const char *path) const{
             std::ifstream file;
             std::string fContent;
             //make sure we can throw exceptions
@@ -157,11 +574,12 @@ class Shader{
          * private helper function to check for compilation and linking errors
          * @param shader an ID to a valid shader or shader program
          * @param shaderType the type of shader passed into the function
+         * @return true if compiling/linking succeeded
          * pre: shaderType == GL_VERTEX_SHADER || GL_FRAGMENT_SHADER || SHADER_PROGRAM
          * post: checks for errors in compilation/linking process
         */
-        void checkError(unsigned int shader, unsigned int shaderType){
-            int success;
+        bool checkError(unsigned int shader, unsigned int shaderType) const{
+            int success = 0;
             char log[1024];
             switch(shaderType){
                 //check error for shader compilation
@@ -193,8 +611,21 @@ class Shader{
                     printf("\nCHECK_ERROR called for undefined type\n");
                     break;
             }
+            return success;
         }
 
 };
 
+template<typename T>
+void Uniform<T>::set(const T &value) const{
+    set(&value, 1);
+}
+
+template<typename T>
+void Uniform<T>::set(const T *values, int count) const{
+    if(shader != NULL){
+        shader->set(*location, values, count);
+    }
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,990 @@
+#include "sierpinski.h"
+#include "ifs.h"
+#include "arena.h"
+#include <math.h>
+#include <string.h>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <memory>
+
+/**
+ * Number of vertices that come before the first triangle of a given depth level.
+ * Level L holds 3^L triangles, so this is 3 * (3^0 + 3^1 + ... + 3^(L-1)) = 3 * (3^L - 1) / 2
+ * @param level the depth level we want the starting vertex of
+ * @return the index of the first vertex of 'level' in a buffer filled by initSierpinski
+*/
+size_t sierpinskiLevelOffset(int level){
+    size_t pow3 = 1;
+    for(int i = 0; i < level; i++){
+        pow3 *= 3;
+    }
+    return 3 * (pow3 - 1) / 2;
+}
+
+/**
+ * Exact number of vertices in a Sierpinski Triangle of a given depth, 3 * (3^(depth+1) - 1) / 2
+ * @param depth the deepest level of the triangle (level 0 is the outer triangle)
+ * @return the number of vertices initSierpinski produces for 'depth'
+*/
+size_t sierpinskiVertexCount(int depth){
+    return sierpinskiLevelOffset(depth + 1);
+}
+
+//----FRACTALS----
+//every fractal but the Sierpinski Triangle itself is an IFS, subdivided by kernels made for its table
+
+//corners of the outer triangle
+static const float TRIANGLE_BASE[6] = {-0.5f, -0.5f,  0.0f,  0.5f,  0.5f, -0.5f};
+//a square as two triangles, the second one the first turned half way around, so the same
+//subdivision rule works for both as long as the maps are symmetric under that turn
+static const float SQUARE_BASE[12] = {-0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f,
+                                       0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f};
+//the hull of a Koch curve from (-0.5, 0) to (0.5, 0)
+static const float KOCH_BASE[6] = {-0.5f, 0.0f,  0.0f, 0.28867513f,  0.5f, 0.0f};
+
+static constexpr IFS<3> SIERPINSKI_IFS = {
+    {shrinkTowards(0.5f, -0.5f, -0.5f), shrinkTowards(0.5f, 0.0f, 0.5f), shrinkTowards(0.5f, 0.5f, -0.5f)},
+    {-0.5f, -0.5f,  0.0f,  0.5f,  0.5f, -0.5f}
+};
+static constexpr IFS<3> SIERPINSKI_THIRD_IFS = {
+    {shrinkTowards(1.0f / 3, -0.5f, -0.5f), shrinkTowards(1.0f / 3, 0.0f, 0.5f), shrinkTowards(1.0f / 3, 0.5f, -0.5f)},
+    {-0.5f, -0.5f,  0.0f,  0.5f,  0.5f, -0.5f}
+};
+static constexpr IFS<8> CARPET_IFS = {
+    {shrinkTowards(1.0f / 3, -0.5f, -0.5f), shrinkTowards(1.0f / 3, 0.0f, -0.5f), shrinkTowards(1.0f / 3, 0.5f, -0.5f),
+     shrinkTowards(1.0f / 3, -0.5f,  0.0f),                                        shrinkTowards(1.0f / 3, 0.5f,  0.0f),
+     shrinkTowards(1.0f / 3, -0.5f,  0.5f), shrinkTowards(1.0f / 3, 0.0f,  0.5f), shrinkTowards(1.0f / 3, 0.5f,  0.5f)},
+    {-0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f}
+};
+static constexpr IFS<5> VICSEK_IFS = {
+    {shrinkTowards(1.0f / 3, -0.5f, -0.5f), shrinkTowards(1.0f / 3, 0.5f, -0.5f), shrinkTowards(1.0f / 3, 0.0f, 0.0f),
+     shrinkTowards(1.0f / 3, -0.5f,  0.5f), shrinkTowards(1.0f / 3, 0.5f,  0.5f)},
+    {-0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f}
+};
+//the middle two pieces of the Koch curve are turned by 60 degrees (cos 0.5, sin 0.8660254)
+static constexpr IFS<4> KOCH_IFS = {
+    {{1.0f / 3, 0.0f, 0.0f, 1.0f / 3, -1.0f / 3, 0.0f},
+     {0.5f / 3, -0.8660254f / 3,  0.8660254f / 3, 0.5f / 3, -1.0f / 12, 0.8660254f / 6},
+     {0.5f / 3,  0.8660254f / 3, -0.8660254f / 3, 0.5f / 3,  1.0f / 12, 0.8660254f / 6},
+     {1.0f / 3, 0.0f, 0.0f, 1.0f / 3,  1.0f / 3, 0.0f}},
+    {-0.5f, 0.0f,  0.0f, 0.28867513f,  0.5f, 0.0f}
+};
+
+static constexpr SubdivisionRule<3> SIERPINSKI_RULE = subdivisionRule(SIERPINSKI_IFS);
+static constexpr SubdivisionRule<3> SIERPINSKI_THIRD_RULE = subdivisionRule(SIERPINSKI_THIRD_IFS);
+static constexpr SubdivisionRule<8> CARPET_RULE = subdivisionRule(CARPET_IFS);
+static constexpr SubdivisionRule<5> VICSEK_RULE = subdivisionRule(VICSEK_IFS);
+static constexpr SubdivisionRule<4> KOCH_RULE = subdivisionRule(KOCH_IFS);
+
+const fractal_t SIERPINSKI_FRACTAL = {"sierpinski", 3, 1, TRIANGLE_BASE, 0.5f, subdivideKernel};
+
+const fractal_t fractals[] = {
+    SIERPINSKI_FRACTAL,
+    {"sierpinski-ifs",      3, 1, TRIANGLE_BASE, 0.5f,      subdivideIFSKernel<3, SIERPINSKI_RULE>},
+    {"sierpinski-third",    3, 1, TRIANGLE_BASE, 1.0f / 3,  subdivideIFSKernel<3, SIERPINSKI_THIRD_RULE>},
+    {"carpet",              8, 2, SQUARE_BASE,   1.0f / 3,  subdivideIFSKernel<8, CARPET_RULE>},
+    {"vicsek",              5, 2, SQUARE_BASE,   1.0f / 3,  subdivideIFSKernel<5, VICSEK_RULE>},
+    {"koch",                4, 1, KOCH_BASE,     1.0f / 3,  subdivideIFSKernel<4, KOCH_RULE>}
+};
+const int FRACTAL_COUNT = sizeof(fractals) / sizeof(fractals[0]);
+
+/**
+ * @param name the name of a fractal, as given with --fractal
+ * @return the fractal with that name, NULL if there is none
+*/
+const fractal_t *findFractal(const char *name){
+    for(int i = 0; i < FRACTAL_COUNT; i++){
+        if(strcmp(fractals[i].name, name) == 0){
+            return &fractals[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Number of vertices that come before the first triangle of a depth level of a fractal.
+ * Level L holds baseCount * maps^L triangles, so this is 3 * baseCount * (maps^L - 1) / (maps - 1)
+ * @param fractal the fractal
+ * @param level the depth level we want the starting vertex of
+ * @return the index of the first vertex of 'level' in a buffer filled by initFractal
+*/
+size_t fractalLevelOffset(const fractal_t &fractal, int level){
+    size_t pow = 1;
+    for(int i = 0; i < level; i++){
+        pow *= fractal.maps;
+    }
+    return 3 * fractal.baseCount * (pow - 1) / (fractal.maps - 1);
+}
+
+/**
+ * @param fractal the fractal
+ * @param depth the deepest level of the fractal
+ * @return the number of vertices initFractal produces for 'depth'
+*/
+size_t fractalVertexCount(const fractal_t &fractal, int depth){
+    return fractalLevelOffset(fractal, depth + 1);
+}
+
+/**
+ * @param fractal the fractal
+ * @param maxVertices the most vertices we are willing to build
+ * @return the deepest depth of 'fractal' that fits in 'maxVertices'
+*/
+int fractalMaxDepth(const fractal_t &fractal, size_t maxVertices){
+    int depth = 0;
+    while(fractalVertexCount(fractal, depth + 1) <= maxVertices){
+        depth++;
+    }
+    return depth;
+}
+
+/**
+ * Helper method to calculate midpoint between two coordinates in 3d space
+ * @param a the first point
+ * @param b the second point
+ * @return a point that contains the x, y, z midpoint coordinates between
+ *         'a' and 'b'
+*/
+point_t midpoint(point_t a, point_t b){
+    point_t p;
+    p.x = (a.x + b.x) * 0.5f;
+    p.y = (a.y + b.y) * 0.5f;
+    p.z = (a.z + b.z) * 0.5f;
+    return p;
+}
+
+/**
+ * Helper function that fills in a vertex from a position and the depth it is drawn at
+ * @param v the vertex to fill in
+ * @param p a point that contains the x, y values of the vertex, z is set from the depth instead
+ * @param depth the current depth of the point for which we wish to draw
+ *              we will use this value to determine what the green color of the vertex should be,
+ *              and its z, LEVEL_Z_STEP nearer for every level so the depth test hides the parents
+ * @param maxDepth the deepest level of the triangle being built
+ * post: v contains the needed position and color data
+*/
+static void setVertex(vertex_t &v, point_t p, int depth, int maxDepth){
+    v.x = p.x;
+    v.y = p.y;
+    v.z = -depth * LEVEL_Z_STEP;
+    v.r = 0.25f;
+    v.g = maxDepth > 0 ? (float)depth / maxDepth : 0.0f;
+    v.b = 0.75f;
+}
+
+/**
+ * Helper function that fills in a packed vertex from a position and the depth it is drawn at
+ * @param v the vertex to fill in
+ * @param p a point that contains the x, y values of the vertex, z is dropped
+ * @param depth the current depth of the point, the vertex shader turns it into a color
+ * the last parameter (the deepest level) is left unnamed: the vertex shader gets it as a uniform
+ * instead, but the generators are templates that call setVertex the same way for every vertex type
+ * post: v contains the position as normalized 16 bit integers, and the depth
+*/
+static void setVertex(packed_vertex_t &v, point_t p, int depth, int){
+    v.x = (short)lrintf(p.x * 32767.0f);
+    v.y = (short)lrintf(p.y * 32767.0f);
+    v.depth = (unsigned char)depth;
+    v.pad[0] = v.pad[1] = v.pad[2] = 0;
+}
+
+/**
+ * Helper function that reads the position back out of a vertex
+ * @param v the vertex we want the position of
+ * @return a point that contains the x, y, z values of 'v'
+*/
+static point_t vertexPos(const vertex_t &v){
+    point_t p = {v.x, v.y, v.z};
+    return p;
+}
+
+/**
+ * Writes the vertices of a level of triangles, 3 per triangle in the order they are held in 'tris'
+ * @param tris the triangles to write
+ * @param out where the 3 * tris.count vertices are written
+ * @param level the depth level of the triangles
+ * @param depth the deepest level of the triangle being built
+ * post: out holds the vertices of every triangle of 'tris'
+*/
+template<typename Vertex>
+void emitSierpinskiLevel(const triangles_t &tris, Vertex *out, int level, int depth){
+    for(size_t i = 0; i < tris.count; i++){
+        point_t a = {tris.ax[i], tris.ay[i], 0.0f};
+        point_t b = {tris.bx[i], tris.by[i], 0.0f};
+        point_t c = {tris.cx[i], tris.cy[i], 0.0f};
+        setVertex(out[3 * i], a, level, depth);
+        setVertex(out[3 * i + 1], b, level, depth);
+        setVertex(out[3 * i + 2], c, level, depth);
+    }
+}
+
+//----SCRATCH MEMORY----
+//the levels being subdivided live in arenas that are reset after every build instead of freed, so
+//regenerating a triangle no larger than the last one allocates nothing. There is one arena per
+//thread that is generating at the same time, taken from a pool that only ever grows.
+//An arena is only ever touched by the thread leasing it, so the stats are copied into the pool
+//when it is given back, and generatorScratchStats reads those copies instead of the arenas
+
+/**
+ * An arena of the pool, with its stats as of the last time it was given back
+ * arena: the arena
+ * highWater: the most bytes it had in use at once during any lease since the stats were reset
+ * reserved: the bytes it held on to when it was given back
+ * grows: how many times its block had been replaced by a larger one
+*/
+typedef struct{
+    std::unique_ptr<Arena> arena;
+    size_t highWater;
+    size_t reserved;
+    size_t grows;
+} pooled_arena_t;
+
+static std::mutex arenaMutex;                       //guards the two below
+static std::vector<pooled_arena_t> arenas;          //every arena ever made
+static std::vector<size_t> freeArenas;              //indices into 'arenas' of the ones no thread is using
+
+/**
+ * An arena taken from the pool for as long as the lease lives, reset and given back when it ends
+*/
+class ArenaLease{
+    public:
+        ArenaLease(){
+            std::lock_guard<std::mutex> lock(arenaMutex);
+            if(freeArenas.empty()){
+                index = arenas.size();
+                arenas.push_back({std::unique_ptr<Arena>(new Arena()), 0, 0, 0});
+                freeArenas.reserve(arenas.size());     //so giving it back never allocates
+            } else{
+                index = freeArenas.back();
+                freeArenas.pop_back();
+            }
+            arena = arenas[index].arena.get();
+        }
+
+        ~ArenaLease(){
+            arena->reset();
+            size_t highWater = arena->highWaterMark();
+            arena->resetHighWaterMark();    //the pool keeps the most of any lease from here on
+            std::lock_guard<std::mutex> lock(arenaMutex);
+            pooled_arena_t &pooled = arenas[index];
+            pooled.highWater = std::max(pooled.highWater, highWater);
+            pooled.reserved = arena->reserved();
+            pooled.grows = arena->growCount();
+            freeArenas.push_back(index);
+        }
+
+        ArenaLease(const ArenaLease &) = delete;
+        ArenaLease &operator=(const ArenaLease &) = delete;
+
+        Arena *arena;
+
+    private:
+        size_t index;   //where the arena is in 'arenas'
+};
+
+/**
+ * Adds up the scratch memory of every arena of the generators, as of when each was last given back,
+ * so it can be called while builds are running
+ * @return the high-water marks and the reserved memory of the arenas, summed
+*/
+scratch_stats_t generatorScratchStats(){
+    std::lock_guard<std::mutex> lock(arenaMutex);
+    scratch_stats_t stats = {0, 0, 0, (int)arenas.size()};
+    for(const pooled_arena_t &pooled : arenas){
+        stats.highWater += pooled.highWater;
+        stats.reserved += pooled.reserved;
+        stats.grows += pooled.grows;
+    }
+    return stats;
+}
+
+/**
+ * Starts the high-water marks of every arena of the generators over, see Arena::resetHighWaterMark
+ * post: builds still running count towards the new high-water marks once they give their arenas back
+*/
+void resetGeneratorScratchStats(){
+    std::lock_guard<std::mutex> lock(arenaMutex);
+    for(pooled_arena_t &pooled : arenas){
+        pooled.highWater = 0;
+    }
+}
+
+/**
+ * Points the arrays of a triangles_t into memory of an arena, every array starting on its own cache line
+ * @param arena the arena to take the memory from
+ * @param capacity the number of triangles the arrays have to hold
+ * @return triangles with room for 'capacity' triangles and a count of 0
+*/
+static triangles_t arenaTriangles(Arena &arena, size_t capacity){
+    triangles_t tris;
+    tris.ax = arena.allocate<float>(capacity);
+    tris.ay = arena.allocate<float>(capacity);
+    tris.bx = arena.allocate<float>(capacity);
+    tris.by = arena.allocate<float>(capacity);
+    tris.cx = arena.allocate<float>(capacity);
+    tris.cy = arena.allocate<float>(capacity);
+    tris.count = 0;
+    return tris;
+}
+
+/**
+ * Builds and writes out every level from 'rootLevel' to 'lastLevel' of the triangles below 'roots'.
+ * Each level is made by subdividing the whole level before it at once (see subdivide for the order),
+ * using two scratch buffers in turn so no level is ever stored twice.
+ * The triangles are written as part of a buffer where, at every level, slice j holds the descendants
+ * of 'roots' number j: level L of this call goes to triangle j * roots.count * maps^(L - rootLevel) of
+ * level L, with level L starting at vertex fractalLevelOffset(fractal, L).
+ * @param fractal the fractal being built
+ * @param kernel the kernel subdividing it, picked by fractal.kernel
+ * @param roots the triangles of 'rootLevel' to start from
+ * @param rootLevel the depth level of 'roots'
+ * @param lastLevel the deepest level to build
+ * @param depth the deepest level of the triangle being built, used for the colors
+ * @param slice the slice 'roots' and their descendants are written to
+ * @param out the vertex buffer to write to
+ * @param arena the arena the levels are held in while they are subdivided
+ * @return the triangles of 'lastLevel', which stay valid until 'arena' is reset or 'roots' is reused
+ * pre: rootLevel <= lastLevel <= depth
+ * post: out holds levels rootLevel to lastLevel of the slice
+*/
+template<typename Vertex>
+static triangles_t buildFractalSubtree(const fractal_t &fractal, subdivide_kernel_t kernel, const triangles_t &roots,
+                                       int rootLevel, int lastLevel, int depth, size_t slice, Vertex *out,
+                                       Arena &arena){
+    //level rootLevel + r is held in levels[(r - 1) % 2], so find the largest level each one holds
+    size_t capacity[2] = {0, 0};
+    size_t count = roots.count;
+    for(int r = 1; r <= lastLevel - rootLevel; r++){
+        count *= fractal.maps;
+        capacity[(r - 1) % 2] = count;
+    }
+    triangles_t levels[2] = {arenaTriangles(arena, capacity[0]), arenaTriangles(arena, capacity[1])};
+
+    const triangles_t *current = &roots;
+    for(int level = rootLevel; ; level++){
+        size_t first = slice * current->count;   //first triangle of this slice within the level
+        emitSierpinskiLevel(*current, out + fractalLevelOffset(fractal, level) + 3 * first, level, depth);
+        if(level == lastLevel){
+            return *current;
+        }
+        triangles_t &next = levels[(level - rootLevel) % 2];
+        kernel(*current, next);
+        current = &next;
+    }
+}
+
+/**
+ * Copies the level 0 triangles of a fractal into a structure of arrays
+ * @param fractal the fractal
+ * @param base the triangles to copy them to
+ * pre: base has room for fractal.baseCount triangles
+ * post: base holds the triangles of level 0
+*/
+static void copyFractalBase(const fractal_t &fractal, triangles_t &base){
+    for(int i = 0; i < fractal.baseCount; i++){
+        const float *corners = fractal.base + 6 * i;
+        base.ax[i] = corners[0];
+        base.ay[i] = corners[1];
+        base.bx[i] = corners[2];
+        base.by[i] = corners[3];
+        base.cx[i] = corners[4];
+        base.cy[i] = corners[5];
+    }
+    base.count = fractal.baseCount;
+}
+
+/**
+ * Copies the level 0 triangles of a fractal into scratch memory, see copyFractalBase
+ * @param fractal the fractal
+ * @param arena the arena holding the coordinates
+ * @return the triangles of level 0
+*/
+static triangles_t fractalBase(const fractal_t &fractal, Arena &arena){
+    triangles_t base = arenaTriangles(arena, fractal.baseCount);
+    copyFractalBase(fractal, base);
+    return base;
+}
+
+/**
+ * Puts the info needed to draw a fractal into a buffer, one depth level at a time.
+ * Every level is built by subdividing the level before it in a structure of arrays, then written
+ * into the buffer (see subdivide for the order).
+ * @param out the buffer we want to fill with vertex data, such as a mapped stream buffer slot.
+ *            Works for every vertex type that has a setVertex overload
+ * @param fractal the fractal to build, such as SIERPINSKI_FRACTAL
+ * @param depth the deepest level to generate (level 0 is the outer triangle)
+ * pre: - depth >= 0
+ *      - out has room for fractalVertexCount(fractal, depth) vertices
+ * post: out holds fractalVertexCount(fractal, depth) vertices, with level L starting at
+ *       fractalLevelOffset(fractal, L), so the smallest triangles are held at the end of the buffer
+*/
+template<typename Vertex>
+void initFractal(Vertex *out, const fractal_t &fractal, int depth){
+    ArenaLease scratch;
+    triangles_t base = fractalBase(fractal, *scratch.arena);
+    buildFractalSubtree(fractal, fractal.kernel(), base, 0, depth, depth, 0, out, *scratch.arena);
+}
+
+/**
+ * Same as initFractal, but split across several threads.
+ * The first 'split' levels are built on the calling thread, then each of the triangles of
+ * level 'split' becomes a task that builds everything below it. Since every level holds the
+ * descendants of a task next to each other, task j owns triangles j * maps^(L-split) up to
+ * (j+1) * maps^(L-split) of level L, and can write them straight into the buffer without locks.
+ * Levels sit at the same offsets as in initFractal, but below level 'split' the triangles of a
+ * level are grouped by task first, so the order within those levels differs.
+ * @param out the buffer we want to fill with vertex data
+ * @param fractal the fractal to build
+ * @param depth the deepest level to generate (level 0 is the outer triangle)
+ * @param threadCount the number of threads to use, 0 to use one per core
+ * pre: - depth >= 0
+ *      - out has room for fractalVertexCount(fractal, depth) vertices
+ * post: out holds fractalVertexCount(fractal, depth) vertices, with level L starting at
+ *       fractalLevelOffset(fractal, L)
+*/
+template<typename Vertex>
+void initFractalParallel(Vertex *out, const fractal_t &fractal, int depth, int threadCount){
+    if(threadCount <= 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    //aim for a few tasks per thread so threads finishing early can pick up more work
+    int split = 0;
+    size_t taskCount = fractal.baseCount;
+    while(split < depth && taskCount < 4 * (size_t)threadCount){
+        split++;
+        taskCount *= fractal.maps;
+    }
+    if(threadCount == 1 || split == 0){
+        initFractal(out, fractal, depth);
+        return;
+    }
+
+    //build the levels above 'split' here, and keep level 'split' as the roots of the tasks
+    subdivide_kernel_t kernel = fractal.kernel();
+    ArenaLease scratch;
+    triangles_t base = fractalBase(fractal, *scratch.arena);
+    triangles_t above = buildFractalSubtree(fractal, kernel, base, 0, split - 1, depth, 0, out, *scratch.arena);
+    triangles_t roots = arenaTriangles(*scratch.arena, taskCount);
+    kernel(above, roots);
+
+    std::atomic<size_t> nextTask{0};
+    auto runTasks = [&](){
+        ArenaLease taskScratch;
+        for(size_t task = nextTask++; task < taskCount; task = nextTask++){
+            triangles_t taskRoot = {roots.ax + task, roots.ay + task, roots.bx + task,
+                                    roots.by + task, roots.cx + task, roots.cy + task, 1};
+            buildFractalSubtree(fractal, kernel, taskRoot, split, depth, depth, task, out, *taskScratch.arena);
+            taskScratch.arena->reset();     //every task builds the same amount, so this stops growing after the first
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount - 1);
+    for(int i = 1; i < threadCount; i++){
+        workers.emplace_back(runTasks);
+    }
+    runTasks();
+    for(std::thread &worker : workers){
+        worker.join();
+    }
+}
+
+/**
+ * Same as initFractal, but writes the vertices strictly front to back in chunks, and reports
+ * every chunk as soon as it is written, so the buffer can be used while it is still being filled.
+ * Since the levels are written in order, the vertices written so far are always the levels above
+ * the one being written plus the start of that level. The order is the same as initFractal's.
+ * @param out the buffer we want to fill with vertex data
+ * @param fractal the fractal to build
+ * @param depth the deepest level to generate (level 0 is the outer triangle)
+ * @param chunkTriangles the most triangles reported at once, a level is split into chunks of this size
+ * @param chunkDone called with the level, first vertex and number of vertices of every chunk once it
+ *                  is written. Returning false stops the generation
+ * @return false if chunkDone stopped the generation
+ * pre: - depth >= 0, chunkTriangles > 0
+ *      - out has room for fractalVertexCount(fractal, depth) vertices
+ * post: if true was returned, out holds fractalVertexCount(fractal, depth) vertices, like initFractal
+*/
+template<typename Vertex>
+bool initFractalProgressive(Vertex *out, const fractal_t &fractal, int depth, size_t chunkTriangles,
+                            const std::function<bool(int level, size_t first, size_t count)> &chunkDone){
+    subdivide_kernel_t kernel = fractal.kernel();
+    ArenaLease scratch;
+    triangles_t base = fractalBase(fractal, *scratch.arena);
+    //levels take turns in the two buffers, so each one only has to hold every other level
+    size_t capacity[2] = {0, 0};
+    size_t levelCount = fractal.baseCount;
+    for(int level = 1; level <= depth; level++){
+        levelCount *= fractal.maps;
+        capacity[(level - 1) % 2] = levelCount;
+    }
+    triangles_t levels[2] = {arenaTriangles(*scratch.arena, capacity[0]), arenaTriangles(*scratch.arena, capacity[1])};
+    const triangles_t *current = &base;
+    for(int level = 0; ; level++){
+        size_t offset = fractalLevelOffset(fractal, level);
+        for(size_t first = 0; first < current->count; first += chunkTriangles){
+            size_t count = std::min(chunkTriangles, current->count - first);
+            triangles_t chunk = {current->ax + first, current->ay + first, current->bx + first,
+                                 current->by + first, current->cx + first, current->cy + first, count};
+            emitSierpinskiLevel(chunk, out + offset + 3 * first, level, depth);
+            if(!chunkDone(level, offset + 3 * first, 3 * count)){
+                return false;
+            }
+        }
+        if(level == depth){
+            return true;
+        }
+        triangles_t &next = levels[level % 2];
+        kernel(*current, next);
+        current = &next;
+    }
+}
+
+/**
+ * Helper function that builds the levels of a fractal below the deepest one built so far
+ * @param fractal the fractal being built
+ * @param frontier the deepest level built so far, updated to each new level in turn
+ * @param depth the deepest level to build
+ * @param emit called with every new level, from frontier.depth + 1 to depth
+ * post: frontier.depth == max(frontier.depth, depth)
+*/
+template<typename Emit>
+static void extendFrontier(const fractal_t &fractal, fractal_frontier_t &frontier, int depth, Emit emit){
+    if(frontier.depth < 0 && depth >= 0){
+        frontier.current = 0;
+        allocTriangles(frontier.level, frontier.storage[0], fractal.baseCount);
+        copyFractalBase(fractal, frontier.level);
+        frontier.depth = 0;
+        emit(frontier.level, 0);
+    }
+    if(frontier.depth >= depth){
+        return;
+    }
+    subdivide_kernel_t kernel = fractal.kernel();
+    while(frontier.depth < depth){
+        //the level before this one is held in the other vector, and is no longer needed
+        int next = 1 - frontier.current;
+        triangles_t children;
+        allocTriangles(children, frontier.storage[next], fractal.maps * frontier.level.count);
+        kernel(frontier.level, children);
+        frontier.level = children;
+        frontier.current = next;
+        frontier.depth++;
+        emit(frontier.level, frontier.depth);
+    }
+}
+
+/**
+ * Builds only the levels of a fractal that are deeper than the ones built before, so a triangle
+ * can be refined one level at a time with each step costing just the triangles it adds.
+ * The levels come out exactly as initFractal writes them, so the vertices of 'out' follow on from
+ * the levels built by the earlier calls.
+ * Vertices are written with the depth given here, so this is only meant for vertex formats whose
+ * colors don't depend on the depth of the whole triangle, such as packed_vertex_t.
+ * @param out where the vertices of the new levels are written, the first one being the first vertex
+ *            of level frontier.depth + 1
+ * @param fractal the fractal to build, the same on every call with the same frontier
+ * @param frontier the deepest level built by the earlier calls, depth -1 to start from level 0
+ * @param depth the deepest level to generate
+ * pre: out has room for fractalVertexCount(fractal, depth) - fractalVertexCount(fractal, frontier.depth)
+ *      vertices
+ * post: - out holds every vertex of the levels frontier.depth + 1 to depth, in the same order as initFractal
+ *       - frontier holds level 'depth', if it was deeper than the level held before
+*/
+template<typename Vertex>
+void extendFractal(Vertex *out, const fractal_t &fractal, fractal_frontier_t &frontier, int depth){
+    size_t start = fractalVertexCount(fractal, frontier.depth);
+    extendFrontier(fractal, frontier, depth, [&](const triangles_t &tris, int level){
+        emitSierpinskiLevel(tris, out + fractalLevelOffset(fractal, level) - start, level, depth);
+    });
+}
+
+/**
+ * Puts the info needed to draw a sierpinski triangle into a buffer, see initFractal
+ * @param out the buffer we want to fill with vertex data
+ * @param depth the deepest level to generate (level 0 is the outer triangle)
+ * pre: - depth >= 0
+ *      - out has room for sierpinskiVertexCount(depth) vertices
+ * post: out holds sierpinskiVertexCount(depth) vertices, with level L starting at
+ *       sierpinskiLevelOffset(L), so the smallest triangles are held at the end of the buffer
+*/
+template<typename Vertex>
+void initSierpinski(Vertex *out, int depth){
+    initFractal(out, SIERPINSKI_FRACTAL, depth);
+}
+
+/**
+ * Same as initSierpinski, but split across several threads, see initFractalParallel
+ * @param out the buffer we want to fill with vertex data
+ * @param depth the deepest level to generate (level 0 is the outer triangle)
+ * @param threadCount the number of threads to use, 0 to use one per core
+*/
+template<typename Vertex>
+void initSierpinskiParallel(Vertex *out, int depth, int threadCount){
+    initFractalParallel(out, SIERPINSKI_FRACTAL, depth, threadCount);
+}
+
+/**
+ * Helper function that finds the vertex at a point of a depth level of an indexed triangle,
+ * adding it if it is not there yet.
+ * Every vertex of level L sits on a grid with a spacing of 2^-(L+1) in x and 2^-L in y, starting
+ * from the bottom left corner (-0.5, -0.5), so its grid coordinates are exact integers we can key on.
+ * @param p the position of the vertex
+ * @param level the depth level the vertex belongs to
+ * @param maxDepth the deepest level of the triangle being built
+ * @param levelVertices the vertices of 'level' added so far, keyed by grid coordinates
+ * @param vertices the vector of unique vertices
+ * @return the index of the vertex in 'vertices'
+*/
+static unsigned int indexedVertex(point_t p, int level, int maxDepth,
+                                  std::unordered_map<unsigned long long, unsigned int> &levelVertices,
+                                  std::vector<vertex_t> &vertices){
+    unsigned long long gridX = lrintf((p.x + 0.5f) * (float)(1 << (level + 1)));
+    unsigned long long gridY = lrintf((p.y + 0.5f) * (float)(1 << level));
+    auto found = levelVertices.emplace((gridX << 32) | gridY, (unsigned int)vertices.size());
+    if(found.second){
+        vertices.emplace_back();
+        setVertex(vertices.back(), p, level, maxDepth);
+    }
+    return found.first->second;
+}
+
+/**
+ * Puts the info needed to draw a sierpinski triangle with an EBO into two vectors. The triangles
+ * come in the same order as initSierpinski, but neighbouring triangles of a level share the vertices
+ * where they touch, so every vertex is only stored once per level. Vertices of different levels are
+ * never shared because they have different colors and z.
+ * A level with 3^L triangles has (3^(L+1) + 3) / 2 unique vertices instead of 3^(L+1).
+ * @param vertices the vector we want to fill with the unique vertices, any previous contents are discarded
+ * @param indices the vector we want to fill with 3 indices into 'vertices' per triangle,
+ *                any previous contents are discarded
+ * @param depth the deepest level to generate (level 0 is the outer triangle)
+ * pre: depth >= 0
+ * post: - indices holds sierpinskiVertexCount(depth) indices, with the triangles of level L
+ *         starting at sierpinskiLevelOffset(L)
+ *       - vertices holds every vertex used by 'indices' exactly once
+*/
+void initSierpinskiIndexed(std::vector<vertex_t> &vertices, std::vector<unsigned int> &indices, int depth){
+    size_t uniqueCount = 0;
+    size_t pow3 = 3;            //3^(L+1)
+    for(int level = 0; level <= depth; level++){
+        uniqueCount += (pow3 + 3) / 2;
+        pow3 *= 3;
+    }
+    vertices.clear();
+    vertices.reserve(uniqueCount);
+    indices.resize(sierpinskiVertexCount(depth));
+    unsigned int *out = indices.data();
+
+    point_t a = {-0.5f, -0.5f,  0.0f};
+    point_t b = { 0.0f,  0.5f,  0.0f};
+    point_t c = { 0.5f, -0.5f,  0.0f};
+    for(int i = 0; i < 3; i++){
+        out[i] = i;
+    }
+    vertices.resize(3);
+    setVertex(vertices[0], a, 0, depth);
+    setVertex(vertices[1], b, 0, depth);
+    setVertex(vertices[2], c, 0, depth);
+
+    std::unordered_map<unsigned long long, unsigned int> levelVertices;
+    size_t parentCount = 1;     //number of triangles in the previous level
+    for(int level = 1; level <= depth; level++){
+        const unsigned int *parents = out + sierpinskiLevelOffset(level - 1);
+        unsigned int *children = out + sierpinskiLevelOffset(level);
+        levelVertices.clear();
+        levelVertices.reserve((3 * parentCount * 3 + 3) / 2);
+        for(size_t i = 0; i < parentCount; i++){
+            point_t pa = vertexPos(vertices[parents[3 * i]]);
+            point_t pb = vertexPos(vertices[parents[3 * i + 1]]);
+            point_t pc = vertexPos(vertices[parents[3 * i + 2]]);
+            unsigned int ia = indexedVertex(pa, level, depth, levelVertices, vertices);
+            unsigned int ib = indexedVertex(pb, level, depth, levelVertices, vertices);
+            unsigned int ic = indexedVertex(pc, level, depth, levelVertices, vertices);
+            unsigned int iab = indexedVertex(midpoint(pa, pb), level, depth, levelVertices, vertices);
+            unsigned int iac = indexedVertex(midpoint(pa, pc), level, depth, levelVertices, vertices);
+            unsigned int ibc = indexedVertex(midpoint(pb, pc), level, depth, levelVertices, vertices);
+
+            unsigned int *t0 = children + 3 * i;
+            unsigned int *t1 = children + 3 * (parentCount + i);
+            unsigned int *t2 = children + 3 * (2 * parentCount + i);
+            t0[0] = ia;  t0[1] = iab; t0[2] = iac;
+            t1[0] = iab; t1[1] = ib;  t1[2] = ibc;
+            t2[0] = iac; t2[1] = ibc; t2[2] = ic;
+        }
+        parentCount *= 3;
+    }
+}
+
+/**
+ * Puts the info needed to draw a sierpinski triangle with instancing into a buffer: one instance
+ * per sub-triangle, holding the offset and scale that map the level 0 (unit) triangle onto it.
+ * The levels and the order within a level match initSierpinski, so instance i draws the same
+ * triangle as vertices 3i to 3i + 2.
+ * A child made from corner p of a parent with offset o and scale s is the parent shrunk by half
+ * towards that corner, so it has offset o + s * p / 2 and scale s / 2.
+ * 'out' is only ever written to, since it may be write-only mapped memory, so each level is also
+ * kept in scratch memory the next level is read from.
+ * @param out the buffer we want to fill with instance data
+ * @param depth the deepest level to generate (level 0 is the outer triangle)
+ * pre: - depth >= 0
+ *      - out has room for sierpinskiVertexCount(depth) / 3 instances
+ * post: out holds sierpinskiVertexCount(depth) / 3 instances, with level L starting at
+ *       sierpinskiLevelOffset(L) / 3
+*/
+void initSierpinskiInstances(instance_t *out, int depth){
+    const point_t corners[3] = {
+        {-0.5f, -0.5f,  0.0f},
+        { 0.0f,  0.5f,  0.0f},
+        { 0.5f, -0.5f,  0.0f}
+    };
+    //level L is held in levels[L % 2], so the largest level either one holds is one of the last two
+    ArenaLease scratch;
+    size_t deepest = sierpinskiVertexCount(depth) - sierpinskiLevelOffset(depth);
+    instance_t *levels[2] = {scratch.arena->allocate<instance_t>(deepest / 3),
+                             scratch.arena->allocate<instance_t>(std::max(deepest / 9, (size_t)1))};
+    if(depth % 2 == 1){
+        std::swap(levels[0], levels[1]);
+    }
+    levels[0][0] = {0.0f, 0.0f, 1.0f, 0.0f};
+    out[0] = levels[0][0];
+
+    size_t parentCount = 1;     //number of triangles in the previous level
+    for(int level = 1; level <= depth; level++){
+        const instance_t *parents = levels[(level - 1) % 2];
+        instance_t *children = levels[level % 2];
+        for(int corner = 0; corner < 3; corner++){
+            for(size_t i = 0; i < parentCount; i++){
+                const instance_t &parent = parents[i];
+                instance_t &child = children[corner * parentCount + i];
+                child.x = parent.x + parent.scale * corners[corner].x * 0.5f;
+                child.y = parent.y + parent.scale * corners[corner].y * 0.5f;
+                child.scale = parent.scale * 0.5f;
+                child.depth = (float)level;
+            }
+        }
+        memcpy(out + sierpinskiLevelOffset(level) / 3, children, parentCount * 3 * sizeof(instance_t));
+        parentCount *= 3;
+    }
+}
+
+
+/**
+ * Same as extendFractal, but builds the instances of initSierpinskiInstances of the new levels.
+ * A triangle of the frontier with corners a, b and c is the unit triangle scaled by c.x - a.x
+ * around the middle of its bounding box
+ * @param out where the instances of the new levels are written, the first one being the first
+ *            instance of level frontier.depth + 1
+ * @param frontier the deepest level built by the earlier calls, depth -1 to start from level 0
+ * @param depth the deepest level to generate
+ * pre: - frontier was only ever extended with SIERPINSKI_FRACTAL
+ *      - out has room for (sierpinskiVertexCount(depth) - sierpinskiVertexCount(frontier.depth)) / 3 instances
+ * post: - out holds the instances of the levels frontier.depth + 1 to depth, like initSierpinskiInstances
+ *       - frontier holds level 'depth', if it was deeper than the level held before
+*/
+void extendSierpinskiInstances(instance_t *out, fractal_frontier_t &frontier, int depth){
+    size_t start = sierpinskiVertexCount(frontier.depth) / 3;
+    extendFrontier(SIERPINSKI_FRACTAL, frontier, depth, [&](const triangles_t &tris, int level){
+        instance_t *levelOut = out + sierpinskiLevelOffset(level) / 3 - start;
+        for(size_t i = 0; i < tris.count; i++){
+            instance_t &instance = levelOut[i];
+            instance.x = (tris.ax[i] + tris.cx[i]) * 0.5f;
+            instance.y = (tris.ay[i] + tris.by[i]) * 0.5f;
+            instance.scale = tris.cx[i] - tris.ax[i];
+            instance.depth = (float)level;
+        }
+    });
+}
+
+/**
+ * Drops the triangles that are entirely outside of a rectangle, keeping the order of the others
+ * @param tris the triangles to cull, compacted in place
+ * @param minX left edge of the rectangle
+ * @param maxX right edge of the rectangle
+ * @param minY bottom edge of the rectangle
+ * @param maxY top edge of the rectangle
+ * @return the number of triangles kept
+ * post: tris.count is the number of triangles kept, and they are the first ones of its arrays
+*/
+size_t cullTriangles(triangles_t &tris, float minX, float maxX, float minY, float maxY){
+    size_t kept = 0;
+    for(size_t i = 0; i < tris.count; i++){
+        //a triangle is inside its bounding box, so if the box misses the rectangle so does it
+        bool outside = std::max(std::max(tris.ax[i], tris.bx[i]), tris.cx[i]) < minX
+                    || std::min(std::min(tris.ax[i], tris.bx[i]), tris.cx[i]) > maxX
+                    || std::max(std::max(tris.ay[i], tris.by[i]), tris.cy[i]) < minY
+                    || std::min(std::min(tris.ay[i], tris.by[i]), tris.cy[i]) > maxY;
+        if(!outside){
+            tris.ax[kept] = tris.ax[i];
+            tris.ay[kept] = tris.ay[i];
+            tris.bx[kept] = tris.bx[i];
+            tris.by[kept] = tris.by[i];
+            tris.cx[kept] = tris.cx[i];
+            tris.cy[kept] = tris.cy[i];
+            kept++;
+        }
+    }
+    tris.count = kept;
+    return kept;
+}
+
+/**
+ * Subdivides triangles in double precision, keeping only the children that overlap a rectangle.
+ * Children are ordered like subdivide orders them: child c of parent i is number c * n + i,
+ * counting the culled ones
+ * @param parents the triangles to subdivide
+ * @param children the vector to put the kept children in, any previous contents are discarded
+ * @param minX left edge of the rectangle
+ * @param maxX right edge of the rectangle
+ * @param minY bottom edge of the rectangle
+ * @param maxY top edge of the rectangle
+*/
+void subdivideTiles(const std::vector<dtriangle_t> &parents, std::vector<dtriangle_t> &children,
+                    double minX, double maxX, double minY, double maxY){
+    children.clear();
+    for(int corner = 0; corner < 3; corner++){
+        for(const dtriangle_t &p : parents){
+            double abx = 0.5 * (p.ax + p.bx), aby = 0.5 * (p.ay + p.by);
+            double acx = 0.5 * (p.ax + p.cx), acy = 0.5 * (p.ay + p.cy);
+            double bcx = 0.5 * (p.bx + p.cx), bcy = 0.5 * (p.by + p.cy);
+            dtriangle_t child;
+            if(corner == 0){
+                child = {p.ax, p.ay, abx, aby, acx, acy};
+            } else if(corner == 1){
+                child = {abx, aby, p.bx, p.by, bcx, bcy};
+            } else{
+                child = {acx, acy, bcx, bcy, p.cx, p.cy};
+            }
+            bool outside = std::max(std::max(child.ax, child.bx), child.cx) < minX
+                        || std::min(std::min(child.ax, child.bx), child.cx) > maxX
+                        || std::max(std::max(child.ay, child.by), child.cy) < minY
+                        || std::min(std::min(child.ay, child.by), child.cy) > maxY;
+            if(!outside){
+                children.push_back(child);
+            }
+        }
+    }
+}
+
+/**
+ * Advances a xoshiro128** generator
+ * @param rng the generator
+ * @return the next 32 random bits
+*/
+static inline uint32_t xoshiro128(xoshiro128_t &rng){
+    uint32_t *s = rng.s;
+    uint32_t mul = s[1] * 5;
+    uint32_t result = ((mul << 7) | (mul >> 25)) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 11) | (s[3] >> 21);
+    return result;
+}
+
+/**
+ * Starts a walk of the chaos game, with its own random sequence
+ * @param walker the walker to start
+ * @param seed picks the random sequence, every seed gives a different one
+ * post: walker is on the attractor (within float precision), and its generator is seeded
+*/
+void seedChaosWalker(chaos_walker_t &walker, uint64_t seed){
+    //splitmix64 spreads the seed over the whole state, which must not be all zero
+    for(int i = 0; i < 4; i += 2){
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z ^= z >> 31;
+        walker.rng.s[i] = (uint32_t)z;
+        walker.rng.s[i + 1] = (uint32_t)(z >> 32) | 1;
+    }
+    //every jump halves the distance to the attractor, so after 32 the start point is forgotten
+    walker.x = 0.0f;
+    walker.y = 0.0f;
+    float discard[2];
+    for(int i = 0; i < 32; i++){
+        chaosGame(walker, discard, 1);
+    }
+}
+
+/**
+ * Plays the chaos game: jumps halfway towards a randomly picked corner of the outer triangle
+ * over and over, so every point lands on the Sierpinski Triangle. Drawing enough of them fills
+ * it in at any resolution, with memory that only depends on how many are drawn at once.
+ * @param walker the walk to continue
+ * @param out where the x and y of every point are written, 2 floats per point
+ * @param count the number of points to write
+ * pre: walker was started with seedChaosWalker
+ * post: out holds 'count' points, and walker is at the last one
+*/
+void chaosGame(chaos_walker_t &walker, float *out, size_t count){
+    static const float cornerX[3] = {-0.5f, 0.0f, 0.5f};
+    static const float cornerY[3] = {-0.5f, 0.5f, -0.5f};
+    xoshiro128_t rng = walker.rng;
+    float x = walker.x, y = walker.y;
+    for(size_t i = 0; i < count; i++){
+        uint32_t corner = (uint32_t)(((uint64_t)xoshiro128(rng) * 3) >> 32);  //0 to 2, without a division
+        x = (x + cornerX[corner]) * 0.5f;
+        y = (y + cornerY[corner]) * 0.5f;
+        out[2 * i] = x;
+        out[2 * i + 1] = y;
+    }
+    walker.rng = rng;
+    walker.x = x;
+    walker.y = y;
+}
+
+/**
+ * Same as chaosGame, but with every walker filling its own part of 'out' on a thread of its own
+ * @param pool the threads to walk on, which stay around between calls (walker 0 runs on the calling thread)
+ * @param walkers the walks to continue, one per thread of the pool
+ * @param out where the x and y of every point are written, 2 floats per point
+ * @param count the number of points to write
+ * pre: - every walker was started with seedChaosWalker, with a different seed
+ *      - walkers.size() == pool.size()
+ * post: out holds 'count' points
+*/
+void chaosGameParallel(WorkerPool &pool, std::vector<chaos_walker_t> &walkers, float *out, size_t count){
+    size_t threadCount = walkers.size();
+    if(threadCount <= 1){
+        if(threadCount == 1){
+            chaosGame(walkers[0], out, count);
+        }
+        return;
+    }
+    //the lambda only captures one reference, so std::function holds it without allocating every frame
+    struct{
+        std::vector<chaos_walker_t> &walkers;
+        float *out;
+        size_t count, perThread;
+    } job = {walkers, out, count, count / threadCount};
+    pool.run([&job](int i){
+        size_t first = i * job.perThread;
+        size_t last = (size_t)i + 1 == job.walkers.size() ? job.count : first + job.perThread;
+        chaosGame(job.walkers[i], job.out + 2 * first, last - first);
+    });
+}
+
+//the vertex formats the generators are used with, see mytypes.h
+template void emitSierpinskiLevel<vertex_t>(const triangles_t &, vertex_t *, int, int);
+template void emitSierpinskiLevel<packed_vertex_t>(const triangles_t &, packed_vertex_t *, int, int);
+template void initSierpinski<vertex_t>(vertex_t *, int);
+template void initSierpinski<packed_vertex_t>(packed_vertex_t *, int);
+template void initSierpinskiParallel<vertex_t>(vertex_t *, int, int);
+template void initSierpinskiParallel<packed_vertex_t>(packed_vertex_t *, int, int);
+template void initFractal<vertex_t>(vertex_t *, const fractal_t &, int);
+template void initFractal<packed_vertex_t>(packed_vertex_t *, const fractal_t &, int);
+template void initFractalParallel<vertex_t>(vertex_t *, const fractal_t &, int, int);
+template void initFractalParallel<packed_vertex_t>(packed_vertex_t *, const fractal_t &, int, int);
+template void extendFractal<vertex_t>(vertex_t *, const fractal_t &, fractal_frontier_t &, int);
+template void extendFractal<packed_vertex_t>(packed_vertex_t *, const fractal_t &, fractal_frontier_t &, int);
+template bool initFractalProgressive<vertex_t>(vertex_t *, const fractal_t &, int, size_t,
+                                               const std::function<bool(int, size_t, size_t)> &);
+template bool initFractalProgressive<packed_vertex_t>(packed_vertex_t *, const fractal_t &, int, size_t,
+                                                      const std::function<bool(int, size_t, size_t)> &);
@@ -0,0 +1,110 @@
+/**
+ * CPU generators of Sierpinski Triangle geometry.
+ * Every generator fills a buffer level by level (level 0 is the outer triangle), with level L
+ * starting at sierpinskiLevelOffset(L), so the levels can be drawn as a prefix of the buffer.
+ * Nothing in here uses OpenGL, so the generators can be built and timed on their own.
+ * 
+*/
+#ifndef SIERPINSKI_H
+#define SIERPINSKI_H
+
+#include <vector>
+#include <functional>
+#include "mytypes.h"
+#include "subdivide.h"
+#include "workerpool.h"
+
+#define MAX_SIERPINSKI_DEPTH 14     //deepest level we allow, depth 14 is already ~500MB of vertices
+#define LEVEL_Z_STEP (1.0f / 64.0f)     //z between depth levels, deeper levels are nearer, down to level 63 in the clip volume
+
+/**
+ * A fractal the mesh generators can build. Every triangle of a level has 'maps' children in the
+ * next one, which the kernel builds for a whole level at once (see subdivide)
+ * name: the name it is picked by with --fractal
+ * maps: the number of children of every triangle
+ * baseCount: the number of triangles of level 0
+ * base: the corners of the triangles of level 0, 6 floats (ax, ay, bx, by, cx, cy) each
+ * ratio: how much smaller the largest child is than its parent
+ * kernel: picks the kernel that subdivides a level
+*/
+typedef struct{
+    const char *name;
+    int maps;
+    int baseCount;
+    const float *base;
+    float ratio;
+    subdivide_kernel_t (*kernel)();
+} fractal_t;
+
+/**
+ * The scratch memory the generators keep between builds, see generatorScratchStats
+ * highWater: the most bytes every arena ever had in use at once, added up
+ * reserved: the bytes the arenas hold on to between builds
+ * grows: how many times an arena had to grow, which stops once the builds stop getting larger
+ * arenas: the number of arenas, one per thread that ever generated at the same time as others
+*/
+typedef struct{
+    size_t highWater;
+    size_t reserved;
+    size_t grows;
+    int arenas;
+} scratch_stats_t;
+
+/**
+ * The deepest level of a fractal built so far by extendFractal, kept so deeper levels can be
+ * built from it later without building the levels above it again
+ * depth: the depth level held, -1 before anything was built
+ * level: the triangles of that level, pointing into one of the storage vectors
+ * storage: memory of 'level' and of the level built from it, used in turn
+ * current: which of the storage vectors 'level' is in
+*/
+typedef struct{
+    int depth = -1;
+    triangles_t level;
+    std::vector<float> storage[2];
+    int current = 0;
+} fractal_frontier_t;
+
+scratch_stats_t generatorScratchStats();
+void resetGeneratorScratchStats();
+
+extern const fractal_t SIERPINSKI_FRACTAL;
+extern const fractal_t fractals[];
+extern const int FRACTAL_COUNT;
+const fractal_t *findFractal(const char *name);
+size_t fractalLevelOffset(const fractal_t &fractal, int level);
+size_t fractalVertexCount(const fractal_t &fractal, int depth);
+int fractalMaxDepth(const fractal_t &fractal, size_t maxVertices);
+
+size_t sierpinskiLevelOffset(int level);
+size_t sierpinskiVertexCount(int depth);
+
+//the templates are instantiated for vertex_t and packed_vertex_t in sierpinski.cpp
+template<typename Vertex>
+void emitSierpinskiLevel(const triangles_t &tris, Vertex *out, int level, int depth);
+template<typename Vertex>
+void initFractal(Vertex *out, const fractal_t &fractal, int depth);
+template<typename Vertex>
+void initFractalParallel(Vertex *out, const fractal_t &fractal, int depth, int threadCount);
+template<typename Vertex>
+bool initFractalProgressive(Vertex *out, const fractal_t &fractal, int depth, size_t chunkTriangles,
+                            const std::function<bool(int level, size_t first, size_t count)> &chunkDone);
+template<typename Vertex>
+void extendFractal(Vertex *out, const fractal_t &fractal, fractal_frontier_t &frontier, int depth);
+template<typename Vertex>
+void initSierpinski(Vertex *out, int depth);
+template<typename Vertex>
+void initSierpinskiParallel(Vertex *out, int depth, int threadCount);
+void initSierpinskiIndexed(std::vector<vertex_t> &vertices, std::vector<unsigned int> &indices, int depth);
+void initSierpinskiInstances(instance_t *out, int depth);
+void extendSierpinskiInstances(instance_t *out, fractal_frontier_t &frontier, int depth);
+
+void seedChaosWalker(chaos_walker_t &walker, uint64_t seed);
+void chaosGame(chaos_walker_t &walker, float *out, size_t count);
+void chaosGameParallel(WorkerPool &pool, std::vector<chaos_walker_t> &walkers, float *out, size_t count);
+
+size_t cullTriangles(triangles_t &tris, float minX, float maxX, float minY, float maxY);
+void subdivideTiles(const std::vector<dtriangle_t> &parents, std::vector<dtriangle_t> &children,
+                    double minX, double maxX, double minY, double maxY);
+
+#endif
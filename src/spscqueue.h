@@ -0,0 +1,82 @@
+/**
+ * Class used to hand work from one thread to another without locks
+ *
+*/
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include<stddef.h>
+#include<atomic>
+
+/**
+ * A bounded queue for exactly one producer thread and one consumer thread.
+ * The items live in a ring of Capacity slots. The producer only ever writes 'tail' and the
+ * consumer only ever writes 'head', so each side publishes its progress with a release store
+ * and reads the other side's with an acquire load, and neither ever waits on a lock.
+ * head and tail sit on their own cache lines so the two threads don't keep taking the line from
+ * each other, and each side keeps a copy of the other's index to only reload it when the queue
+ * looks full or empty.
+ * Capacity: the number of slots, a power of two, one of them is always left empty
+*/
+template<typename T, size_t Capacity>
+class SPSCQueue{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        /**
+         * Adds an item to the back of the queue, only ever called from the producer thread
+         * @param item the item to add
+         * @return false if the queue is full, in which case nothing was added
+        */
+        bool push(const T &item){
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t next = (t + 1) & (Capacity - 1);
+            if(next == cachedHead){
+                cachedHead = head.load(std::memory_order_acquire);
+                if(next == cachedHead){
+                    return false;
+                }
+            }
+            items[t] = item;
+            tail.store(next, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Takes the item at the front of the queue, only ever called from the consumer thread
+         * @param item set to the item taken
+         * @return false if the queue is empty, in which case item is left alone
+        */
+        bool pop(T &item){
+            size_t h = head.load(std::memory_order_relaxed);
+            if(h == cachedTail){
+                cachedTail = tail.load(std::memory_order_acquire);
+                if(h == cachedTail){
+                    return false;
+                }
+            }
+            item = items[h];
+            head.store((h + 1) & (Capacity - 1), std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Empties the queue
+         * pre: neither thread is using the queue
+        */
+        void clear(){
+            head.store(0, std::memory_order_relaxed);
+            tail.store(0, std::memory_order_relaxed);
+            cachedHead = 0;
+            cachedTail = 0;
+        }
+
+    private:
+        alignas(64) std::atomic<size_t> head{0};    //next slot to pop, written by the consumer
+        size_t cachedTail = 0;                      //the consumer's copy of tail
+        alignas(64) std::atomic<size_t> tail{0};    //next slot to push to, written by the producer
+        size_t cachedHead = 0;                      //the producer's copy of head
+        alignas(64) T items[Capacity];
+};
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * Class used to stream regenerated geometry straight into GPU memory
+ * 
+*/
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include<glad/glad.h>   //get required OpenGL headers
+
+#include<stdio.h>
+#include<vector>
+
+/**
+ * A ring of buffer objects ("slots") that geometry is written into through a mapped pointer,
+ * instead of being built in a std::vector and copied in with glBufferData.
+ * On GL 4.4+ every slot is created with glBufferStorage and stays persistently and coherently
+ * mapped. On older contexts a slot is mapped with glMapBufferRange (invalidate + unsynchronized)
+ * for each write and unmapped afterwards.
+ * Each slot has its own buffer object so that drawing from one slot is still allowed while
+ * another one is mapped on a 3.3 context.
+ * A slot that is retired gets a fence, and the next write to it waits for that fence first, so
+ * we never overwrite data the GPU is still reading.
+*/
+class StreamBuffer{
+    public:
+        /**
+         * Constructor for a StreamBuffer object
+         * @param slotCount the number of slots in the ring
+         * pre: an OpenGL context is current
+         * post: StreamBuffer constructed with 'slotCount' empty slots
+        */
+        StreamBuffer(int slotCount){
+            slots.resize(slotCount);
+            persistent = GLAD_GL_VERSION_4_4;
+        }
+
+        /**
+         * Deconstructor for the StreamBuffer.
+         * Deletes the buffer objects and fences of every slot
+        */
+        ~StreamBuffer(){
+            for(Slot &slot : slots){
+                if(slot.fence != 0){
+                    glDeleteSync(slot.fence);
+                }
+                if(slot.buffer != 0){
+                    glDeleteBuffers(1, &slot.buffer);     //also unmaps it
+                }
+            }
+        }
+
+        StreamBuffer(const StreamBuffer &) = delete;
+        StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+        /**
+         * Gets a slot ready to be written to, and gives back a pointer into its memory
+         * @param slot the slot to write to
+         * @param size the number of bytes that will be written
+         * @return a pointer to at least 'size' writable bytes, which may be written from any thread,
+         *         or NULL if the slot could not be mapped
+         * pre: slot is not being drawn from, and is not already being written to
+         * post: - the GPU is no longer reading from the slot
+         *       - the slot's buffer object holds at least 'size' bytes. It may be a new buffer
+         *         object, so check buffer(slot) again before drawing from it
+         *       - the slot must be passed to endWrite before it is drawn from
+        */
+        void *beginWrite(int slot, size_t size){
+            Slot &s = slots[slot];
+            waitFence(s);
+            if(persistent){
+                if(s.capacity < size){
+                    //immutable storage can't grow, so replace the whole buffer object
+                    if(s.buffer != 0){
+                        glDeleteBuffers(1, &s.buffer);
+                    }
+                    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+                    glGenBuffers(1, &s.buffer);
+                    glBindBuffer(GL_ARRAY_BUFFER, s.buffer);
+                    glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+                    s.mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+                    s.capacity = size;
+                    glBindBuffer(GL_ARRAY_BUFFER, 0);
+                }
+            } else{
+                if(s.buffer == 0){
+                    glGenBuffers(1, &s.buffer);
+                }
+                glBindBuffer(GL_ARRAY_BUFFER, s.buffer);
+                if(s.capacity < size){
+                    glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+                    s.capacity = size;
+                }
+                //the fence already tells us the GPU is done with it, so skip any driver sync
+                s.mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size,
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+            }
+            if(s.mapped == NULL){
+                printf("\nERROR MAPPING STREAM BUFFER\n");
+            }
+            return s.mapped;
+        }
+
+        /**
+         * Finishes a write started by beginWrite
+         * @param slot the slot that was written to
+         * @return false if the contents of the slot were lost and have to be written again
+         * pre: nothing is writing to the slot anymore
+         * post: the slot can be drawn from
+        */
+        bool endWrite(int slot){
+            Slot &s = slots[slot];
+            if(persistent){
+                return s.mapped != NULL;    //coherent, so the writes are already visible to the GPU
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, s.buffer);
+            bool intact = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            s.mapped = NULL;
+            return intact;
+        }
+
+        /**
+         * Marks a slot as no longer drawn from by new commands
+         * @param slot the slot to retire
+         * pre: every draw reading from the slot has already been issued
+         * post: the next beginWrite on the slot waits until the GPU has finished those draws
+        */
+        void retire(int slot){
+            Slot &s = slots[slot];
+            if(s.fence != 0){
+                glDeleteSync(s.fence);
+            }
+            s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        /**
+         * @param slot the slot to get the buffer object of
+         * @return the id of the buffer object holding the slot, 0 if nothing was ever written to it
+        */
+        unsigned int buffer(int slot) const{
+            return slots[slot].buffer;
+        }
+
+        /**
+         * @return true if the slots are persistently mapped (GL 4.4+), false if they are mapped per write
+        */
+        bool isPersistent() const{
+            return persistent;
+        }
+
+    private:
+        /**
+         * buffer: id of the buffer object, 0 if not generated yet
+         * capacity: size of the buffer object's storage in bytes
+         * mapped: pointer to the mapped storage, NULL if not mapped
+         * fence: signalled once the GPU is done with the slot, 0 if there is nothing to wait on
+        */
+        struct Slot{
+            unsigned int buffer = 0;
+            size_t capacity = 0;
+            void *mapped = NULL;
+            GLsync fence = 0;
+        };
+
+        std::vector<Slot> slots;
+        bool persistent;
+
+        /**
+         * private helper function that blocks until the GPU is done with a slot
+         * @param s the slot to wait on
+         * post: s has no fence
+        */
+        void waitFence(Slot &s){
+            if(s.fence == 0){
+                return;
+            }
+            GLenum result = glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            while(result == GL_TIMEOUT_EXPIRED){
+                result = glClientWaitSync(s.fence, 0, 1000000);
+            }
+            glDeleteSync(s.fence);
+            s.fence = 0;
+        }
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "subdivide.h"
+#ifdef SUBDIVIDE_X86
+#include <immintrin.h>
+#endif
+#ifdef SUBDIVIDE_NEON
+#include <arm_neon.h>
+#endif
+
+/**
+ * Subdivides triangles begin up to end of 'parents' one at a time, see subdivideScalar.
+ * The SIMD kernels use it for the triangles left over after their last full vector.
+ * @param parents the triangles to subdivide
+ * @param children the triangles to write the children to
+ * @param begin the first triangle of 'parents' to subdivide
+ * @param end one past the last triangle of 'parents' to subdivide
+*/
+static void subdivideRange(const triangles_t &parents, triangles_t &children, size_t begin, size_t end){
+    const size_t n = parents.count;
+    for(size_t i = begin; i < end; i++){
+        float ax = parents.ax[i], ay = parents.ay[i];
+        float bx = parents.bx[i], by = parents.by[i];
+        float cx = parents.cx[i], cy = parents.cy[i];
+        float abx = (ax + bx) * 0.5f, aby = (ay + by) * 0.5f;
+        float acx = (ax + cx) * 0.5f, acy = (ay + cy) * 0.5f;
+        float bcx = (bx + cx) * 0.5f, bcy = (by + cy) * 0.5f;
+
+        //child 0: corner a
+        children.ax[i] = ax;            children.ay[i] = ay;
+        children.bx[i] = abx;           children.by[i] = aby;
+        children.cx[i] = acx;           children.cy[i] = acy;
+        //child 1: corner b
+        children.ax[n + i] = abx;       children.ay[n + i] = aby;
+        children.bx[n + i] = bx;        children.by[n + i] = by;
+        children.cx[n + i] = bcx;       children.cy[n + i] = bcy;
+        //child 2: corner c
+        children.ax[2 * n + i] = acx;   children.ay[2 * n + i] = acy;
+        children.bx[2 * n + i] = bcx;   children.by[2 * n + i] = bcy;
+        children.cx[2 * n + i] = cx;    children.cy[2 * n + i] = cy;
+    }
+}
+
+/**
+ * Builds the next depth level out of a level of triangles.
+ * Child c of parent i becomes triangle c * parents.count + i of 'children', so the triangles made
+ * from corner a of every parent come first, then those made from corner b, then those made from
+ * corner c. Each child lists its corners in the same order as its parent, so every triangle keeps
+ * the winding of the outer one.
+ * @param parents the triangles to subdivide
+ * @param children the triangles to write the children to
+ * pre: children has room for 3 * parents.count triangles, and does not overlap parents
+ * post: children.count == 3 * parents.count, and children holds the 3 children of every parent
+*/
+void subdivideScalar(const triangles_t &parents, triangles_t &children){
+    subdivideRange(parents, children, 0, parents.count);
+    children.count = 3 * parents.count;
+}
+
+#ifdef SUBDIVIDE_X86
+/**
+ * subdivideScalar, 4 triangles at a time with SSE
+ * @param parents the triangles to subdivide
+ * @param children the triangles to write the children to
+*/
+void subdivideSSE(const triangles_t &parents, triangles_t &children){
+    const size_t n = parents.count;
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m128 ax = _mm_loadu_ps(parents.ax + i), ay = _mm_loadu_ps(parents.ay + i);
+        __m128 bx = _mm_loadu_ps(parents.bx + i), by = _mm_loadu_ps(parents.by + i);
+        __m128 cx = _mm_loadu_ps(parents.cx + i), cy = _mm_loadu_ps(parents.cy + i);
+        __m128 abx = _mm_mul_ps(_mm_add_ps(ax, bx), half), aby = _mm_mul_ps(_mm_add_ps(ay, by), half);
+        __m128 acx = _mm_mul_ps(_mm_add_ps(ax, cx), half), acy = _mm_mul_ps(_mm_add_ps(ay, cy), half);
+        __m128 bcx = _mm_mul_ps(_mm_add_ps(bx, cx), half), bcy = _mm_mul_ps(_mm_add_ps(by, cy), half);
+
+        _mm_storeu_ps(children.ax + i, ax);             _mm_storeu_ps(children.ay + i, ay);
+        _mm_storeu_ps(children.bx + i, abx);            _mm_storeu_ps(children.by + i, aby);
+        _mm_storeu_ps(children.cx + i, acx);            _mm_storeu_ps(children.cy + i, acy);
+        _mm_storeu_ps(children.ax + n + i, abx);        _mm_storeu_ps(children.ay + n + i, aby);
+        _mm_storeu_ps(children.bx + n + i, bx);         _mm_storeu_ps(children.by + n + i, by);
+        _mm_storeu_ps(children.cx + n + i, bcx);        _mm_storeu_ps(children.cy + n + i, bcy);
+        _mm_storeu_ps(children.ax + 2 * n + i, acx);    _mm_storeu_ps(children.ay + 2 * n + i, acy);
+        _mm_storeu_ps(children.bx + 2 * n + i, bcx);    _mm_storeu_ps(children.by + 2 * n + i, bcy);
+        _mm_storeu_ps(children.cx + 2 * n + i, cx);     _mm_storeu_ps(children.cy + 2 * n + i, cy);
+    }
+    subdivideRange(parents, children, i, n);
+    children.count = 3 * n;
+}
+
+/**
+ * subdivideScalar, 8 triangles at a time with AVX2.
+ * Compiled for AVX2 on its own, so the rest of the program still runs on CPUs without it.
+ * @param parents the triangles to subdivide
+ * @param children the triangles to write the children to
+ * pre: the CPU supports AVX2
+*/
+__attribute__((target("avx2")))
+void subdivideAVX2(const triangles_t &parents, triangles_t &children){
+    const size_t n = parents.count;
+    const __m256 half = _mm256_set1_ps(0.5f);
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        __m256 ax = _mm256_loadu_ps(parents.ax + i), ay = _mm256_loadu_ps(parents.ay + i);
+        __m256 bx = _mm256_loadu_ps(parents.bx + i), by = _mm256_loadu_ps(parents.by + i);
+        __m256 cx = _mm256_loadu_ps(parents.cx + i), cy = _mm256_loadu_ps(parents.cy + i);
+        __m256 abx = _mm256_mul_ps(_mm256_add_ps(ax, bx), half), aby = _mm256_mul_ps(_mm256_add_ps(ay, by), half);
+        __m256 acx = _mm256_mul_ps(_mm256_add_ps(ax, cx), half), acy = _mm256_mul_ps(_mm256_add_ps(ay, cy), half);
+        __m256 bcx = _mm256_mul_ps(_mm256_add_ps(bx, cx), half), bcy = _mm256_mul_ps(_mm256_add_ps(by, cy), half);
+
+        _mm256_storeu_ps(children.ax + i, ax);          _mm256_storeu_ps(children.ay + i, ay);
+        _mm256_storeu_ps(children.bx + i, abx);         _mm256_storeu_ps(children.by + i, aby);
+        _mm256_storeu_ps(children.cx + i, acx);         _mm256_storeu_ps(children.cy + i, acy);
+        _mm256_storeu_ps(children.ax + n + i, abx);     _mm256_storeu_ps(children.ay + n + i, aby);
+        _mm256_storeu_ps(children.bx + n + i, bx);      _mm256_storeu_ps(children.by + n + i, by);
+        _mm256_storeu_ps(children.cx + n + i, bcx);     _mm256_storeu_ps(children.cy + n + i, bcy);
+        _mm256_storeu_ps(children.ax + 2 * n + i, acx); _mm256_storeu_ps(children.ay + 2 * n + i, acy);
+        _mm256_storeu_ps(children.bx + 2 * n + i, bcx); _mm256_storeu_ps(children.by + 2 * n + i, bcy);
+        _mm256_storeu_ps(children.cx + 2 * n + i, cx);  _mm256_storeu_ps(children.cy + 2 * n + i, cy);
+    }
+    subdivideRange(parents, children, i, n);
+    children.count = 3 * n;
+}
+#endif
+
+#ifdef SUBDIVIDE_NEON
+/**
+ * subdivideScalar, 4 triangles at a time with NEON
+ * @param parents the triangles to subdivide
+ * @param children the triangles to write the children to
+*/
+void subdivideNEON(const triangles_t &parents, triangles_t &children){
+    const size_t n = parents.count;
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        float32x4_t ax = vld1q_f32(parents.ax + i), ay = vld1q_f32(parents.ay + i);
+        float32x4_t bx = vld1q_f32(parents.bx + i), by = vld1q_f32(parents.by + i);
+        float32x4_t cx = vld1q_f32(parents.cx + i), cy = vld1q_f32(parents.cy + i);
+        float32x4_t abx = vmulq_f32(vaddq_f32(ax, bx), half), aby = vmulq_f32(vaddq_f32(ay, by), half);
+        float32x4_t acx = vmulq_f32(vaddq_f32(ax, cx), half), acy = vmulq_f32(vaddq_f32(ay, cy), half);
+        float32x4_t bcx = vmulq_f32(vaddq_f32(bx, cx), half), bcy = vmulq_f32(vaddq_f32(by, cy), half);
+
+        vst1q_f32(children.ax + i, ax);             vst1q_f32(children.ay + i, ay);
+        vst1q_f32(children.bx + i, abx);            vst1q_f32(children.by + i, aby);
+        vst1q_f32(children.cx + i, acx);            vst1q_f32(children.cy + i, acy);
+        vst1q_f32(children.ax + n + i, abx);        vst1q_f32(children.ay + n + i, aby);
+        vst1q_f32(children.bx + n + i, bx);         vst1q_f32(children.by + n + i, by);
+        vst1q_f32(children.cx + n + i, bcx);        vst1q_f32(children.cy + n + i, bcy);
+        vst1q_f32(children.ax + 2 * n + i, acx);    vst1q_f32(children.ay + 2 * n + i, acy);
+        vst1q_f32(children.bx + 2 * n + i, bcx);    vst1q_f32(children.by + 2 * n + i, bcy);
+        vst1q_f32(children.cx + 2 * n + i, cx);     vst1q_f32(children.cy + 2 * n + i, cy);
+    }
+    subdivideRange(parents, children, i, n);
+    children.count = 3 * n;
+}
+#endif
+
+/**
+ * Picks the fastest subdivision kernel the CPU we are running on supports.
+ * The check only runs on the first call, afterwards the same kernel is returned.
+ * @return the kernel to use for subdividing triangles
+*/
+subdivide_kernel_t subdivideKernel(){
+    static const subdivide_kernel_t kernel = [](){
+#ifdef SUBDIVIDE_X86
+        if(__builtin_cpu_supports("avx2")){
+            return subdivideAVX2;
+        }
+        if(__builtin_cpu_supports("sse")){
+            return subdivideSSE;
+        }
+#endif
+#ifdef SUBDIVIDE_NEON
+        return subdivideNEON;
+#endif
+        return subdivideScalar;
+    }();
+    return kernel;
+}
+
+/**
+ * @return the name of the kernel subdivideKernel picks, e.g. for logging
+*/
+const char *subdivideKernelName(){
+    subdivide_kernel_t kernel = subdivideKernel();
+#ifdef SUBDIVIDE_X86
+    if(kernel == subdivideAVX2) return "avx2";
+    if(kernel == subdivideSSE) return "sse";
+#endif
+#ifdef SUBDIVIDE_NEON
+    if(kernel == subdivideNEON) return "neon";
+#endif
+    return "scalar";
+}
+
+/**
+ * Subdivides a level of triangles with the kernel picked by subdivideKernel
+ * @param parents the triangles to subdivide
+ * @param children the triangles to write the children to
+ * pre: children has room for 3 * parents.count triangles, and does not overlap parents
+ * post: children.count == 3 * parents.count, and children holds the 3 children of every parent
+*/
+void subdivide(const triangles_t &parents, triangles_t &children){
+    subdivideKernel()(parents, children);
+}
+
+/**
+ * Points the arrays of a triangles_t into a vector of floats with room for 'capacity' triangles
+ * @param tris the triangles to set up
+ * @param storage the vector holding the coordinates, grown if it is too small
+ * @param capacity the number of triangles tris has to hold
+ * post: tris has room for 'capacity' triangles and tris.count == 0
+*/
+void allocTriangles(triangles_t &tris, std::vector<float> &storage, size_t capacity){
+    if(storage.size() < 6 * capacity){
+        storage.resize(6 * capacity);
+    }
+    float *base = storage.data();
+    tris.ax = base;
+    tris.ay = base + capacity;
+    tris.bx = base + 2 * capacity;
+    tris.by = base + 3 * capacity;
+    tris.cx = base + 4 * capacity;
+    tris.cy = base + 5 * capacity;
+    tris.count = 0;
+}
@@ -0,0 +1,32 @@
+/**
+ * Kernels that subdivide a whole depth level of Sierpinski triangles at once.
+ * Triangles are kept as a structure of arrays (triangles_t) so every kernel reads and
+ * writes whole vectors of x or y coordinates, and stays in float the whole way.
+ * 
+*/
+#ifndef SUBDIVIDE_H
+#define SUBDIVIDE_H
+
+#include <vector>
+#include "mytypes.h"
+
+//signature shared by every subdivision kernel, see subdivideScalar
+typedef void (*subdivide_kernel_t)(const triangles_t &parents, triangles_t &children);
+
+void subdivideScalar(const triangles_t &parents, triangles_t &children);
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SUBDIVIDE_X86
+void subdivideSSE(const triangles_t &parents, triangles_t &children);
+void subdivideAVX2(const triangles_t &parents, triangles_t &children);
+#endif
+#if defined(__ARM_NEON)
+#define SUBDIVIDE_NEON
+void subdivideNEON(const triangles_t &parents, triangles_t &children);
+#endif
+
+subdivide_kernel_t subdivideKernel();
+const char *subdivideKernelName();
+void subdivide(const triangles_t &parents, triangles_t &children);
+void allocTriangles(triangles_t &tris, std::vector<float> &storage, size_t capacity);
+
+#endif
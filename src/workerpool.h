@@ -0,0 +1,113 @@
+/**
+ * Class used to run the same task on several threads over and over, without starting threads each time
+ *
+*/
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include<stddef.h>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+#include<vector>
+
+/**
+ * A fixed set of threads that sleep on a condition variable between tasks. run() hands every
+ * thread the same task along with its index, runs index 0 on the calling thread itself and
+ * returns once all of them are done, so a task run every frame costs a wakeup per thread
+ * instead of creating and joining them.
+*/
+class WorkerPool{
+    public:
+        /**
+         * Constructor for a WorkerPool
+         * @param threadCount the number of threads tasks run on, the calling thread of run() included
+        */
+        WorkerPool(int threadCount){
+            for(int i = 1; i < threadCount; i++){
+                threads.emplace_back(&WorkerPool::work, this, i);
+            }
+        }
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        /**
+         * Destructor for a WorkerPool, waits for the threads to stop
+         * pre: no run() is in progress
+        */
+        ~WorkerPool(){
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            wake.notify_all();
+            for(std::thread &thread : threads){
+                thread.join();
+            }
+        }
+
+        /**
+         * Runs a task on every thread of the pool, and waits for it
+         * @param task called once with every index from 0 to size() - 1, index 0 on the calling thread
+         * post: every call of 'task' has returned
+        */
+        void run(const std::function<void(int index)> &task){
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                current = &task;
+                pending = threads.size();
+                generation++;
+            }
+            wake.notify_all();
+            task(0);
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this](){ return pending == 0; });
+            current = NULL;
+        }
+
+        /**
+         * @return the number of threads tasks run on, the calling thread of run() included
+        */
+        int size() const{
+            return (int)threads.size() + 1;
+        }
+
+    private:
+        std::vector<std::thread> threads;
+        std::mutex mutex;                                   //guards everything below
+        std::condition_variable wake;                       //signalled when there is a task or the pool stops
+        std::condition_variable finished;                   //signalled when the last thread finished the task
+        const std::function<void(int)> *current = NULL;     //the task being run
+        size_t pending = 0;                                 //threads that have not finished it yet
+        unsigned long generation = 0;                       //counts the tasks, so every thread runs each one once
+        bool stop = false;
+
+        /**
+         * private helper function that every thread of the pool runs until the pool stops
+         * @param index the index the thread passes to every task
+        */
+        void work(int index){
+            unsigned long done = 0;
+            while(true){
+                const std::function<void(int)> *task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this, done](){ return stop || generation != done; });
+                    if(stop){
+                        return;
+                    }
+                    done = generation;
+                    task = current;
+                }
+                (*task)(index);
+                std::lock_guard<std::mutex> lock(mutex);
+                if(--pending == 0){
+                    finished.notify_one();
+                }
+            }
+        }
+};
+
+#endif